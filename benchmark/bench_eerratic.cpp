@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "eerratic_clock.h"
+#include "eerratic_timer_bank.hpp"
+#include "eerratic_timer_class.hpp"
+#include "eerratic_tsc_clock.hpp"
+
+
+// Overhead and wake-up accuracy of the timing primitives and EEerraticTimer.
+// Built with the nanosecond time base against the real steady clock; one CSV
+// row per case:
+//
+//   benchmark,param,samples,mean_ns,p50_ns,p99_ns,max_ns
+//
+// clock/*             cost of one get_current_time_func call per clock provider
+// overhead/*          per-call cost with nothing to wait for
+// deadline/*          overshoot past a 1 ms budget (param: wait policy)
+// event_latency/*     event set -> wait returned (param: policy@offset% of timeout);
+//                     eerratic_event rows signal an EEerraticEvent instead of a polled flag
+// concurrent_timers/* loop period error with N timer threads (param: N)
+// timer_bank/*        expiry check cost per channel, one is_timer_expired call each
+//                     vs one EEerraticTimerBank::scan (param: channel count)
+// step_table/*        executeSleep step lookup and bookkeeping with a frozen clock
+//                     and a set event (param: previous unordered_map lookup,
+//                     step id or StepHandle)
+
+static_assert(EERRATIC_TIME_BASE == EERRATIC_TIME_BASE_NS64, "benchmark expects nanosecond ticks");
+
+static const int kOverheadBatches = 200;
+static const int kOverheadBatchSize = 1000;
+static const int kDeadlineSamples = 100;
+static const int kEventSamples = 40;
+static const int kConcurrentLoops = 100;
+static const eerratic_tick_t kBudget = 1000000;    // 1 ms
+static const eerratic_tick_t kFarAway = 1000000000000ull;
+
+static std::atomic<bool> g_event{false};
+static std::atomic<eerratic_tick_t> g_eventTime{0};
+
+eerratic_tick_t get_steady_time_impl() {
+    return static_cast<eerratic_tick_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void sleep_impl(eerratic_tick_t ticks) {
+    std::this_thread::sleep_for(std::chrono::nanoseconds(ticks));
+}
+
+void no_sleep_impl(eerratic_tick_t) {
+}
+
+void yield_impl() {
+    std::this_thread::yield();
+}
+
+bool is_event_set_impl() {
+    return g_event.load(std::memory_order_acquire);
+}
+
+static const char* policyName(wait_policy_t policy) {
+    switch (policy) {
+    case WAIT_POLICY_SPIN: return "spin";
+    case WAIT_POLICY_YIELD: return "yield";
+    case WAIT_POLICY_BLOCK: return "block";
+    case WAIT_POLICY_ADAPTIVE: return "adaptive";
+    }
+    return "unknown";
+}
+
+static void report(const std::string& name, const std::string& param, std::vector<double> samples) {
+    if (samples.empty()) {
+        std::printf("%s,%s,0,,,,\n", name.c_str(), param.c_str());
+        return;
+    }
+    std::sort(samples.begin(), samples.end());
+    double sum = 0.0;
+    for (double sample : samples) {
+        sum += sample;
+    }
+    const size_t count = samples.size();
+    std::printf("%s,%s,%zu,%.1f,%.1f,%.1f,%.1f\n", name.c_str(), param.c_str(), count,
+        sum / static_cast<double>(count), samples[count / 2],
+        samples[std::min(count - 1, count * 99 / 100)], samples[count - 1]);
+    std::fflush(stdout);
+}
+
+// Per-call cost in ns, one sample per batch to keep clock reads out of the result
+template <typename F>
+static std::vector<double> measure_overhead(F&& func) {
+    std::vector<double> samples;
+    volatile int sink = 0;
+    for (int batch = 0; batch < kOverheadBatches; batch++) {
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < kOverheadBatchSize; i++) {
+            sink = sink + func();
+        }
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / kOverheadBatchSize);
+    }
+    return samples;
+}
+
+static EEerraticTscClock* g_tscClock = nullptr;
+
+eerratic_tick_t get_tsc_time_impl() {
+    return g_tscClock->now();
+}
+
+eerratic_tick_t get_system_time_impl() {
+    return static_cast<eerratic_tick_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+}
+
+// The expiry check before it shared one clock read between the loop and step checks
+static ERROR_CODE is_timer_expired_two_reads(eerratic_tick_t loop_start_time, eerratic_tick_t loop_expected_elapsed_time,
+    eerratic_tick_t start_time, eerratic_tick_t expected_elapsed_time, get_current_time_func_t get_current_time_func) {
+    if (get_current_time_func() - loop_start_time >= loop_expected_elapsed_time) {
+        return ERROR_CODE_TOTAL_TIMEOUT;
+    } else if (get_current_time_func() - start_time >= expected_elapsed_time) {
+        return ERROR_CODE_TIMEOUT;
+    }
+    return ERROR_CODE_OK;
+}
+
+static void bench_clock() {
+    const struct {
+        get_current_time_func_t func;
+        const char* name;
+    } kClocks[] = {
+        { get_system_time_impl, "system_clock" },
+        { get_steady_time_impl, "steady_clock" },
+        { eerratic_monotonic_time, "eerratic_monotonic_time" },
+        { get_tsc_time_impl, g_tscClock->isTscEnabled() ? "tsc" : "tsc_fallback" },
+    };
+    for (const auto& clock : kClocks) {
+        report("clock/read", clock.name, measure_overhead([&clock] {
+            return static_cast<int>(clock.func());
+        }));
+    }
+    for (const auto& clock : kClocks) {
+        get_current_time_func_t func = clock.func;
+        const eerratic_tick_t start = func();
+        report("clock/is_timer_expired_two_reads", clock.name, measure_overhead([func, start] {
+            return static_cast<int>(is_timer_expired_two_reads(start, kFarAway, start, kFarAway, func));
+        }));
+        report("clock/is_timer_expired", clock.name, measure_overhead([func, start] {
+            return static_cast<int>(is_timer_expired(start, kFarAway, start, kFarAway, func));
+        }));
+    }
+}
+
+static void bench_overhead() {
+    g_event = true;
+    report("overhead/is_timer_expired", "-", measure_overhead([] {
+        eerratic_tick_t now = get_steady_time_impl();
+        return static_cast<int>(is_timer_expired(now, kFarAway, now, kFarAway, get_steady_time_impl));
+    }));
+    report("overhead/sleep_remaining_time", "-", measure_overhead([] {
+        eerratic_tick_t elapsed = 0;
+        sleep_remaining_time(get_steady_time_impl(), kFarAway, kBudget, &elapsed, get_steady_time_impl, no_sleep_impl);
+        return static_cast<int>(elapsed);
+    }));
+    report("overhead/wait_timeout_or_event", "-", measure_overhead([] {
+        eerratic_tick_t elapsed = 0;
+        return static_cast<int>(wait_timeout_or_event(get_steady_time_impl(), kFarAway, kBudget, &elapsed,
+            get_steady_time_impl, is_event_set_impl));
+    }));
+    report("overhead/wait_time_and_event", "-", measure_overhead([] {
+        eerratic_tick_t elapsed = 0;
+        return static_cast<int>(wait_time_and_event(get_steady_time_impl(), kFarAway, 0, &elapsed,
+            get_steady_time_impl, is_event_set_impl, no_sleep_impl));
+    }));
+
+    const struct {
+        sleep_type_t type;
+        const char* name;
+    } kSleepTypes[] = {
+        { SLEEP_REMAINING_TIME, "sleep_remaining_time" },
+        { WAIT_EVENT, "wait_event" },
+        { WAIT_TIME_AND_EVENT, "wait_time_and_event" },
+    };
+    for (const auto& sleepType : kSleepTypes) {
+        EEerraticTimer timer(static_cast<eerratic_tick_t>(kFarAway), get_steady_time_impl, no_sleep_impl);
+        EEerraticTimer::StepHandle handle = timer.addStep(0, sleepType.type == WAIT_EVENT ? kBudget : 0,
+            is_event_set_impl, sleepType.type);
+        timer.resetLoop();
+        report(std::string("overhead/execute_sleep/") + sleepType.name, "-", measure_overhead([&] {
+            return static_cast<int>(timer.executeSleep(handle));
+        }));
+    }
+    g_event = false;
+}
+
+static void bench_deadline() {
+    std::vector<double> samples;
+    for (int i = 0; i < kDeadlineSamples; i++) {
+        eerratic_tick_t elapsed = 0;
+        sleep_remaining_time(get_steady_time_impl(), kFarAway, kBudget, &elapsed, get_steady_time_impl, sleep_impl);
+        samples.push_back(static_cast<double>(elapsed) - static_cast<double>(kBudget));
+    }
+    report("deadline/sleep_remaining_time", "-", samples);
+
+    g_event = false;
+    const wait_policy_t kPolicies[] = { WAIT_POLICY_SPIN, WAIT_POLICY_YIELD, WAIT_POLICY_BLOCK, WAIT_POLICY_ADAPTIVE };
+    for (wait_policy_t policy : kPolicies) {
+        wait_backend_t backend = { policy, yield_impl, NULL };
+        samples.clear();
+        for (int i = 0; i < kDeadlineSamples; i++) {
+            eerratic_tick_t elapsed = 0;
+            wait_timeout_or_event_with_backend(get_steady_time_impl(), kFarAway, kBudget, &elapsed,
+                get_steady_time_impl, is_event_set_impl, sleep_impl, &backend);
+            samples.push_back(static_cast<double>(elapsed) - static_cast<double>(kBudget));
+        }
+        report("deadline/wait_timeout_or_event", policyName(policy), samples);
+    }
+
+    EEerraticTimer timer(kBudget, get_steady_time_impl, sleep_impl);
+    EEerraticTimer::StepHandle handle = timer.addStep(0, kBudget, nullptr, SLEEP_REMAINING_TIME);
+    samples.clear();
+    for (int i = 0; i < kDeadlineSamples; i++) {
+        timer.resetLoop();
+        timer.executeSleep(handle);
+        samples.push_back(static_cast<double>(timer.getLastElapsedTime()) - static_cast<double>(kBudget));
+    }
+    report("deadline/execute_sleep", "sleep_remaining_time", samples);
+
+    // Measured against the loop deadline, as reported by the step itself
+    handle = timer.addStep(1, kBudget, nullptr, SLEEP_REMAINING_TIME_PRECISE);
+    samples.clear();
+    for (int i = 0; i < kDeadlineSamples; i++) {
+        precise_sleep_t state;
+        timer.resetLoop();
+        timer.executeSleep(handle);
+        timer.getPreciseSleepState(1, state);
+        samples.push_back(static_cast<double>(state.last_error));
+    }
+    report("deadline/execute_sleep", "sleep_remaining_time_precise", samples);
+}
+
+static void bench_event_latency() {
+    const wait_policy_t kPolicies[] = { WAIT_POLICY_SPIN, WAIT_POLICY_YIELD, WAIT_POLICY_BLOCK, WAIT_POLICY_ADAPTIVE };
+    const int kOffsetsPercent[] = { 0, 25, 50, 90, 99 };
+    const eerratic_tick_t kTimeout = 2 * kBudget;
+
+    for (wait_policy_t policy : kPolicies) {
+        wait_backend_t backend = { policy, yield_impl, NULL };
+        for (int offsetPercent : kOffsetsPercent) {
+            std::vector<double> samples;
+            for (int i = 0; i < kEventSamples; i++) {
+                g_event = false;
+                const eerratic_tick_t start = get_steady_time_impl();
+                const eerratic_tick_t setAt = start + kTimeout * static_cast<eerratic_tick_t>(offsetPercent) / 100;
+                std::thread setter([setAt] {
+                    eerratic_tick_t now = get_steady_time_impl();
+                    if (setAt > now) {
+                        std::this_thread::sleep_for(std::chrono::nanoseconds(setAt - now));
+                    }
+                    g_eventTime.store(get_steady_time_impl(), std::memory_order_relaxed);
+                    g_event.store(true, std::memory_order_release);
+                });
+                eerratic_tick_t elapsed = 0;
+                ERROR_CODE result = wait_timeout_or_event_with_backend(start, kFarAway, kTimeout, &elapsed,
+                    get_steady_time_impl, is_event_set_impl, sleep_impl, &backend);
+                const eerratic_tick_t returnedAt = get_steady_time_impl();
+                setter.join();
+                // Only waits that saw the event measure wake-up latency
+                if (result == ERROR_CODE_OK) {
+                    samples.push_back(static_cast<double>(returnedAt - g_eventTime.load(std::memory_order_relaxed)));
+                }
+            }
+            report("event_latency/wait_timeout_or_event",
+                std::string(policyName(policy)) + "@" + std::to_string(offsetPercent), samples);
+        }
+    }
+    g_event = false;
+
+    // The same waits pushed through EEerraticEvent instead of a polled flag
+    for (int offsetPercent : kOffsetsPercent) {
+        std::vector<double> samples;
+        for (int i = 0; i < kEventSamples; i++) {
+            EEerraticEvent event;
+            EEerraticTimer timer(kFarAway, get_steady_time_impl, sleep_impl);
+            EEerraticTimer::StepHandle handle = timer.addStep(0, kTimeout, event, WAIT_EVENT);
+            timer.resetLoop();
+            const eerratic_tick_t setAt = timer.getLoopStartTime() + kTimeout * static_cast<eerratic_tick_t>(offsetPercent) / 100;
+            std::thread setter([setAt, &event] {
+                eerratic_tick_t now = get_steady_time_impl();
+                if (setAt > now) {
+                    std::this_thread::sleep_for(std::chrono::nanoseconds(setAt - now));
+                }
+                g_eventTime.store(get_steady_time_impl(), std::memory_order_relaxed);
+                event.set();
+            });
+            ERROR_CODE result = timer.executeSleep(handle);
+            const eerratic_tick_t returnedAt = get_steady_time_impl();
+            setter.join();
+            if (result == ERROR_CODE_OK) {
+                samples.push_back(static_cast<double>(returnedAt - g_eventTime.load(std::memory_order_relaxed)));
+            }
+        }
+        report("event_latency/eerratic_event", "block@" + std::to_string(offsetPercent), samples);
+    }
+}
+
+static void bench_concurrent_timers() {
+    const int kTimerCounts[] = { 1, 2, 4, 8 };
+    const eerratic_tick_t kPeriod = 2 * kBudget;
+
+    for (int timerCount : kTimerCounts) {
+        std::vector<std::vector<double>> perThread(static_cast<size_t>(timerCount));
+        std::vector<std::thread> threads;
+        for (int t = 0; t < timerCount; t++) {
+            threads.emplace_back([&perThread, t, kPeriod] {
+                EEerraticTimer timer(kPeriod, get_steady_time_impl, sleep_impl);
+                EEerraticTimer::StepHandle handle = timer.addStep(0, kPeriod, nullptr, SLEEP_REMAINING_TIME);
+                timer.resetLoop();
+                for (int i = 0; i < kConcurrentLoops; i++) {
+                    const eerratic_tick_t loopStart = timer.getLoopStartTime();
+                    timer.executeSleep(handle);
+                    timer.resetLoop();
+                    const double period = static_cast<double>(timer.getLoopStartTime() - loopStart);
+                    perThread[static_cast<size_t>(t)].push_back(period - static_cast<double>(kPeriod));
+                }
+            });
+        }
+        std::vector<double> samples;
+        for (int t = 0; t < timerCount; t++) {
+            threads[static_cast<size_t>(t)].join();
+            samples.insert(samples.end(), perThread[static_cast<size_t>(t)].begin(), perThread[static_cast<size_t>(t)].end());
+        }
+        report("concurrent_timers/execute_sleep", std::to_string(timerCount), samples);
+    }
+}
+
+// Per-channel cost in ns of checking every channel once, one sample per pass
+template <typename F>
+static std::vector<double> measure_per_channel(size_t channelCount, F&& pass) {
+    std::vector<double> samples;
+    volatile size_t sink = 0;
+    for (int batch = 0; batch < kOverheadBatches; batch++) {
+        auto start = std::chrono::steady_clock::now();
+        sink = sink + pass();
+        auto end = std::chrono::steady_clock::now();
+        samples.push_back(std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(channelCount));
+    }
+    return samples;
+}
+
+static void bench_timer_bank() {
+    for (size_t channelCount : { 64u, 1024u, 4096u }) {
+        // Budgets spread so that part of the channels is expired at any time
+        const eerratic_tick_t base = get_steady_time_impl();
+        std::vector<eerratic_tick_t> budgets(channelCount);
+        EEerraticTimerBank bank(channelCount);
+        for (size_t channel = 0; channel < channelCount; channel++) {
+            budgets[channel] = kBudget * (channel % 16);
+            bank.setChannel(channel, base, kFarAway, base, budgets[channel]);
+        }
+
+        report("timer_bank/is_timer_expired", std::to_string(channelCount), measure_per_channel(channelCount, [&] {
+            size_t expired = 0;
+            for (size_t channel = 0; channel < channelCount; channel++) {
+                expired += is_timer_expired(base, kFarAway, base, budgets[channel], get_steady_time_impl) != ERROR_CODE_OK;
+            }
+            return expired;
+        }));
+        report("timer_bank/scan", std::to_string(channelCount), measure_per_channel(channelCount, [&] {
+            return bank.scan(get_steady_time_impl());
+        }));
+    }
+}
+
+static const int kTableStepCount = 8;
+
+eerratic_tick_t get_frozen_time_impl() {
+    return 0;
+}
+
+bool is_event_always_set_impl() {
+    return true;
+}
+
+// The step lookup executeSleep used before the dense step table
+class MapStepTimer {
+public:
+    MapStepTimer() {
+        m_timerUtils.get_current_time_func = get_frozen_time_impl;
+        m_timerUtils.sleep_func = no_sleep_impl;
+    }
+
+    void addStep(int id, eerratic_tick_t expectedElapsedTime, is_event_set_func_t isEventSetFunc, sleep_type_t sleepType) {
+        m_steps[id] = { expectedElapsedTime, isEventSetFunc, sleepType, {}, 0, 0, 0, 0, 0 };
+    }
+
+#if defined(__GNUC__)
+    __attribute__((noinline))
+#endif
+    ERROR_CODE executeSleep(int id) {
+        auto it = m_steps.find(id);
+        if (it == m_steps.end()) {
+            return ERROR_CODE_INVALID_PARAMETER;
+        }
+        m_timerUtils.expected_elapsed_time = it->second.expectedElapsedTime;
+        m_timerUtils.is_event_set_func = it->second.isEventSetFunc;
+        ERROR_CODE result = eerratic_sleep(0, kBudget, &m_timerUtils, it->second.sleepType);
+        if (result == ERROR_CODE_OK || result == ERROR_CODE_TIMEOUT) {
+            it->second.record(m_timerUtils.elapsed_time, result);
+        }
+        return result;
+    }
+
+private:
+    struct Step {
+        eerratic_tick_t expectedElapsedTime;
+        is_event_set_func_t isEventSetFunc;
+        sleep_type_t sleepType;
+        EEerraticHistogram histogram;
+        uint64_t overrunCount;
+        uint64_t elapsedSum;
+        uint64_t jitterSum;
+        eerratic_tick_t maxJitter;
+        eerratic_tick_t lastElapsed;
+
+        // Same bookkeeping as EEerraticTimer's per-step statistics
+        void record(eerratic_tick_t elapsed, ERROR_CODE result) {
+            if (histogram.getTotalCount() > 0) {
+                eerratic_tick_t jitter = elapsed > lastElapsed ? elapsed - lastElapsed : lastElapsed - elapsed;
+                jitterSum += jitter;
+                maxJitter = jitter > maxJitter ? jitter : maxJitter;
+            }
+            histogram.record(elapsed);
+            elapsedSum += elapsed;
+            lastElapsed = elapsed;
+            if (result == ERROR_CODE_TIMEOUT || result == ERROR_CODE_TOTAL_TIMEOUT) {
+                overrunCount++;
+            }
+        }
+    };
+
+    timer_utils_t m_timerUtils{};
+    std::unordered_map<int, Step> m_steps;
+};
+
+static void bench_step_table() {
+    MapStepTimer mapTimer;
+    EEerraticTimer timer(kBudget, get_frozen_time_impl, no_sleep_impl);
+    EEerraticTimer::StepHandle handles[kTableStepCount];
+    for (int id = 0; id < kTableStepCount; id++) {
+        mapTimer.addStep(id, kBudget / 10, is_event_always_set_impl, WAIT_EVENT);
+        handles[id] = timer.addStep(id, kBudget / 10, is_event_always_set_impl, WAIT_EVENT);
+    }
+    timer.resetLoop();
+
+    int id = 0;
+    auto nextId = [&id] {
+        id = (id + 1) % kTableStepCount;
+        return id;
+    };
+    report("step_table/execute_sleep", "unordered_map", measure_overhead([&] {
+        return static_cast<int>(mapTimer.executeSleep(nextId()));
+    }));
+    report("step_table/execute_sleep", "id", measure_overhead([&] {
+        return static_cast<int>(timer.executeSleep(nextId()));
+    }));
+    report("step_table/execute_sleep", "handle", measure_overhead([&] {
+        return static_cast<int>(timer.executeSleep(handles[nextId()]));
+    }));
+}
+
+int main() {
+    EEerraticTscClock tscClock;
+    g_tscClock = &tscClock;
+    std::printf("benchmark,param,samples,mean_ns,p50_ns,p99_ns,max_ns\n");
+    bench_clock();
+    bench_overhead();
+    bench_deadline();
+    bench_event_latency();
+    bench_concurrent_timers();
+    bench_timer_bank();
+    bench_step_table();
+    return 0;
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "eerratic_schedule.hpp"
+
+
+std::atomic<bool> flag{false};
+
+eerratic_tick_t get_current_time_impl() {
+    using namespace std::chrono;
+    return static_cast<eerratic_tick_t>(
+        duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count()
+    );
+}
+
+void sleep_ms_impl(eerratic_tick_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+bool is_event_set_impl() {
+    return flag.load();
+}
+
+void thread_func() {
+    std::cout << "Thread started" << std::endl;
+    std::this_thread::sleep_for(std::chrono::seconds(2));
+    flag.store(true);
+}
+
+// Same loop as the EEerraticTimer example, checked at compile time:
+// 2500 + 2500 + 500 <= 7000, and step 3 sleeps out the rest of the loop.
+using Schedule = EEerraticSchedule<7000, get_current_time_impl, sleep_ms_impl,
+    EEerraticStep<WAIT_EVENT,           2500, is_event_set_impl>,
+    EEerraticStep<WAIT_TIME_AND_EVENT,  2500, is_event_set_impl>,
+    EEerraticStep<WAIT_EVENT,           500,  is_event_set_impl>,
+    EEerraticStep<SLEEP_REMAINING_TIME, EERRATIC_LOOP_REMAINDER>>;
+
+int main() {
+    Schedule schedule;
+    std::cout << "Schedule headroom: " << Schedule::kHeadroom << " ms" << std::endl;
+
+    std::thread worker;
+    schedule.runLoop([&](auto step) {
+        if (worker.joinable()) {
+            worker.join();
+        }
+        if (step() < 3) {
+            flag.store(false);
+            worker = std::thread(thread_func);
+        }
+    });
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    std::cout << "Step 0 elapsed time: " << schedule.getElapsedTime<0>() << " ms" << std::endl;
+    std::cout << "Step 1 elapsed time: " << schedule.getElapsedTime<1>() << " ms" << std::endl;
+    std::cout << "Step 2 elapsed time: " << schedule.getElapsedTime<2>() << " ms" << std::endl;
+    std::cout << "Step 3 elapsed time: " << schedule.getElapsedTime<3>() << " ms" << std::endl;
+    std::cout << "----------------" << std::endl;
+    std::cout << "\u23F1 Total elapsed time: " 
+              << (get_current_time_impl() - schedule.getLoopStartTime()) << " ms" << std::endl;
+
+    return 0;
+}
@@ -7,18 +7,16 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/time.h>
 #include <unistd.h>
 
+#include "eerratic_clock.h"
 #include "eerratic_timer.h"
 
 
 bool flag = false;
 
 uint32_t get_current_time_impl(void) {
-    struct timeval tv;
-    gettimeofday(&tv, NULL);
-    return (uint32_t)(tv.tv_sec * 1000 + tv.tv_usec / 1000);
+    return eerratic_monotonic_time();
 }
 
 void sleep_ms_impl(uint32_t ms) {
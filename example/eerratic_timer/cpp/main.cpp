@@ -10,16 +10,14 @@
 #include <thread>
 
 extern "C" {
+#include "eerratic_clock.h"
 #include "eerratic_timer.h"
 }
 
 std::atomic<bool> flag{false};
 
 uint32_t get_current_time_impl() {
-    using namespace std::chrono;
-    return static_cast<uint32_t>(
-        duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count()
-    );
+    return eerratic_monotonic_time();
 }
 
 void sleep_ms_impl(uint32_t ms) {
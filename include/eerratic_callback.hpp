@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_CALLBACK_HPP
+#define EERRATIC_CALLBACK_HPP
+
+#include <cstddef>
+#include <functional>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+template <typename Signature, std::size_t Capacity = 4 * sizeof(void*)>
+class EEerraticCallback;
+
+/**
+ * @brief Type-erased callable with inline storage and no heap allocation
+ *
+ * The callable is stored in a fixed buffer of Capacity bytes; larger
+ * callables are rejected at compile time. invoker() and target() expose the
+ * erased call as a C context callback (function pointer + void* context),
+ * so it can be plugged straight into timer_utils_ctx_t.
+ */
+template <typename R, typename... Args, std::size_t Capacity>
+class EEerraticCallback<R(Args...), Capacity> {
+public:
+    using invoker_t = R (*)(void*, Args...);
+
+    EEerraticCallback() = default;
+    EEerraticCallback(std::nullptr_t) {}
+
+    template <typename F,
+              typename Fn = std::decay_t<F>,
+              typename = std::enable_if_t<!std::is_same<Fn, EEerraticCallback>::value &&
+                                          std::is_invocable_r<R, Fn&, Args...>::value>>
+    EEerraticCallback(F&& func) {
+        static_assert(sizeof(Fn) <= Capacity, "callable does not fit in EEerraticCallback storage");
+        static_assert(alignof(Fn) <= alignof(std::max_align_t), "callable is over-aligned");
+
+        // A function reference decays to a pointer that cannot be null
+        if constexpr ((std::is_pointer<Fn>::value || std::is_member_pointer<Fn>::value)
+                      && !std::is_function<std::remove_reference_t<F>>::value) {
+            if (func == nullptr) {
+                return;
+            }
+        }
+        ::new (static_cast<void*>(&m_storage)) Fn(std::forward<F>(func));
+        m_invoker = &invoke<Fn>;
+        m_manager = &manage<Fn>;
+    }
+
+    EEerraticCallback(const EEerraticCallback& other) {
+        copyFrom(other);
+    }
+
+    EEerraticCallback& operator=(const EEerraticCallback& other) {
+        if (this != &other) {
+            reset();
+            copyFrom(other);
+        }
+        return *this;
+    }
+
+    ~EEerraticCallback() {
+        reset();
+    }
+
+    R operator()(Args... args) const {
+        return m_invoker(target(), std::forward<Args>(args)...);
+    }
+
+    explicit operator bool() const {
+        return m_invoker != nullptr;
+    }
+
+    invoker_t invoker() const {
+        return m_invoker;
+    }
+
+    void* target() const {
+        return const_cast<void*>(static_cast<const void*>(&m_storage));
+    }
+
+    void reset() {
+        if (m_manager != nullptr) {
+            m_manager(target(), nullptr);
+        }
+        m_invoker = nullptr;
+        m_manager = nullptr;
+    }
+
+private:
+    // Copy-constructs into dst when non-null, destroys src otherwise
+    using manager_t = void (*)(void* src, void* dst);
+
+    template <typename Fn>
+    static R invoke(void* storage, Args... args) {
+        // std::invoke also calls pointers to members on their first argument
+        if constexpr (std::is_void<R>::value) {
+            std::invoke(*static_cast<Fn*>(storage), std::forward<Args>(args)...);
+        } else {
+            return std::invoke(*static_cast<Fn*>(storage), std::forward<Args>(args)...);
+        }
+    }
+
+    template <typename Fn>
+    static void manage(void* src, void* dst) {
+        if (dst != nullptr) {
+            ::new (dst) Fn(*static_cast<const Fn*>(src));
+        } else {
+            static_cast<Fn*>(src)->~Fn();
+        }
+    }
+
+    void copyFrom(const EEerraticCallback& other) {
+        if (other.m_manager != nullptr) {
+            other.m_manager(other.target(), target());
+        }
+        m_invoker = other.m_invoker;
+        m_manager = other.m_manager;
+    }
+
+    alignas(std::max_align_t) unsigned char m_storage[Capacity];
+    invoker_t m_invoker = nullptr;
+    manager_t m_manager = nullptr;
+};
+
+#endif // EERRATIC_CALLBACK_HPP
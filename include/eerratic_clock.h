@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_CLOCK_H
+#define EERRATIC_CLOCK_H
+
+#include "eerratic_timer.h"
+
+#include <time.h>
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Monotonic clock provider for hosted POSIX builds. CLOCK_MONOTONIC never
+ * jumps with wall clock changes, and on Linux clock_gettime() is served by
+ * the vDSO without a system call. Bare-metal builds keep supplying their
+ * own get_current_time_func (for example a hardware tick counter).
+ */
+
+/**
+ * @brief Get the monotonic time in nanoseconds
+ * 
+ * @return uint64_t Nanoseconds since an unspecified start
+ */
+static inline uint64_t eerratic_monotonic_ns(void)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+}
+
+/**
+ * @brief Get the monotonic time in eerratic_tick_t units of the selected time base
+ * 
+ * @return eerratic_tick_t The current time (wraps freely)
+ */
+static inline eerratic_tick_t eerratic_monotonic_time(void)
+{
+    return (eerratic_tick_t)(eerratic_monotonic_ns() / (1000000000u / EERRATIC_TICKS_PER_SEC));
+}
+
+/**
+ * @brief eerratic_monotonic_time() as a context callback for timer_utils_ctx_t
+ * 
+ * @param ctx Unused
+ * @return eerratic_tick_t The current time
+ */
+static inline eerratic_tick_t eerratic_monotonic_time_ctx(void* ctx)
+{
+    (void)ctx;
+    return eerratic_monotonic_time();
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EERRATIC_CLOCK_H
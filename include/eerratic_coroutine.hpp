@@ -0,0 +1,236 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_COROUTINE_HPP
+#define EERRATIC_COROUTINE_HPP
+
+#if !defined(__cpp_impl_coroutine)
+#error "eerratic_coroutine.hpp requires C++20 coroutines"
+#endif
+
+#include "eerratic_timer_class.hpp"
+
+#include <algorithm>
+#include <coroutine>
+#include <exception>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+/**
+ * @brief Single-threaded executor for loops written as coroutines
+ *
+ * A loop is a coroutine returning EEerraticExecutor::Task that drives one
+ * EEerraticTimer and awaits its steps:
+ *
+ *     EEerraticExecutor::Task loop(EEerraticExecutor& executor, EEerraticTimer& timer) {
+ *         timer.resetLoop();
+ *         ERROR_CODE result = co_await executor.step(timer, 0);
+ *         ...
+ *     }
+ *
+ * A step has the same semantics, result and statistics as executeSleep(),
+ * but the coroutine is suspended instead of the thread: run() resumes it
+ * once the step deadline passed or, for steps waiting on an event, when a
+ * poll every pollInterval sees the event set. Between resumptions the
+ * executor sleeps until the earliest deadline. Each loop costs one coroutine
+ * frame instead of a thread stack. The executor, its time and sleep
+ * functions and all timers must be used from the thread calling run(), and
+ * the time function must be the timers' clock.
+ */
+class EEerraticExecutor {
+public:
+    using TimeFunction = EEerraticTimer::TimeFunction;
+    using SleepFunction = EEerraticTimer::SleepFunction;
+
+    class Task {
+    public:
+        struct promise_type {
+            EEerraticExecutor* executor = nullptr;
+            std::exception_ptr exception;
+
+            Task get_return_object() {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+            // Started by the executor, not by the call
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            // Finished frames are destroyed by run()
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() {}
+            void unhandled_exception() { exception = std::current_exception(); }
+        };
+
+        Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+        Task& operator=(Task&&) = delete;
+        ~Task() {
+            if (m_handle) {
+                m_handle.destroy();
+            }
+        }
+
+    private:
+        friend class EEerraticExecutor;
+        explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    class StepAwaiter {
+    public:
+        bool await_ready() {
+            m_result = m_timer->beginStep(m_step);
+            if (m_result != ERROR_CODE_OK) {
+                return true;
+            }
+            m_result = m_executor->poll(*this, m_executor->m_getCurrentTimeFunc());
+            return m_result != ERROR_CODE_PENDING;
+        }
+        void await_suspend(std::coroutine_handle<Task::promise_type> handle) {
+            m_handle = handle;
+            m_executor->pushWaiter(this);
+        }
+        ERROR_CODE await_resume() const { return m_result; }
+
+    private:
+        friend class EEerraticExecutor;
+        StepAwaiter(EEerraticExecutor* executor, EEerraticTimer* timer, EEerraticTimer::StepHandle step)
+            : m_executor(executor), m_timer(timer), m_step(step) {}
+
+        EEerraticExecutor* m_executor;
+        EEerraticTimer* m_timer;
+        EEerraticTimer::StepHandle m_step;
+        std::coroutine_handle<Task::promise_type> m_handle{};
+        ERROR_CODE m_result = ERROR_CODE_OK;
+        eerratic_tick_t m_wakeTime = 0;
+    };
+
+    EEerraticExecutor(TimeFunction getTimeFunc, SleepFunction sleepFunc, eerratic_tick_t pollInterval = 1)
+        : m_getCurrentTimeFunc(getTimeFunc),
+          m_sleepFunc(sleepFunc),
+          m_pollInterval(pollInterval ? pollInterval : 1)
+    {
+        if (!m_getCurrentTimeFunc) {
+            throw std::invalid_argument("get_current_time_func is null");
+        }
+    }
+
+    ~EEerraticExecutor() {
+        for (std::coroutine_handle<Task::promise_type> task : m_tasks) {
+            task.destroy();
+        }
+    }
+
+    EEerraticExecutor(const EEerraticExecutor&) = delete;
+    EEerraticExecutor& operator=(const EEerraticExecutor&) = delete;
+
+    // Takes ownership of the loop; it starts on the next run()
+    void spawn(Task task) {
+        std::coroutine_handle<Task::promise_type> handle = std::exchange(task.m_handle, nullptr);
+        handle.promise().executor = this;
+        m_tasks.push_back(handle);
+        m_ready.push_back(handle);
+    }
+
+    // co_await result: the step's ERROR_CODE, as executeSleep() would return it
+    StepAwaiter step(EEerraticTimer& timer, EEerraticTimer::StepHandle handle) {
+        return StepAwaiter(this, &timer, handle);
+    }
+
+    StepAwaiter step(EEerraticTimer& timer, int id) {
+        return StepAwaiter(this, &timer, timer.getStepHandle(id));
+    }
+
+    /**
+     * @brief Run the spawned loops until all of them returned
+     *
+     * An exception escaping a loop is rethrown here once the loop's frame is
+     * destroyed; the other loops stay suspended and run() may be called again.
+     */
+    void run() {
+        while (!m_tasks.empty()) {
+            if (!m_ready.empty()) {
+                resumeReady();
+                continue;
+            }
+            if (m_waiters.empty()) {
+                throw std::logic_error("loops are suspended on something other than a step");
+            }
+
+            const eerratic_tick_t now = m_getCurrentTimeFunc();
+            while (!m_waiters.empty() && !tickBefore(now, m_waiters.front()->m_wakeTime)) {
+                std::pop_heap(m_waiters.begin(), m_waiters.end(), laterWake);
+                StepAwaiter* awaiter = m_waiters.back();
+                m_waiters.pop_back();
+                awaiter->m_result = poll(*awaiter, now);
+                if (awaiter->m_result == ERROR_CODE_PENDING) {
+                    pushWaiter(awaiter);
+                } else {
+                    m_ready.push_back(awaiter->m_handle);
+                }
+            }
+            if (m_ready.empty() && m_sleepFunc) {
+                m_sleepFunc(m_waiters.front()->m_wakeTime - now);
+            }
+        }
+    }
+
+    size_t getTaskCount() const { return m_tasks.size(); }
+
+private:
+    static bool tickBefore(eerratic_tick_t lhs, eerratic_tick_t rhs) {
+        return static_cast<std::make_signed_t<eerratic_tick_t>>(lhs - rhs) < 0;
+    }
+
+    // Min-heap on the wake time
+    static bool laterWake(const StepAwaiter* lhs, const StepAwaiter* rhs) {
+        return tickBefore(rhs->m_wakeTime, lhs->m_wakeTime);
+    }
+
+    ERROR_CODE poll(StepAwaiter& awaiter, eerratic_tick_t now) {
+        ERROR_CODE result = awaiter.m_timer->pollStep(now, awaiter.m_wakeTime);
+        if (result == ERROR_CODE_PENDING && awaiter.m_timer->isPollingEvent()
+            && tickBefore(now + m_pollInterval, awaiter.m_wakeTime)) {
+            awaiter.m_wakeTime = now + m_pollInterval;
+        }
+        return result;
+    }
+
+    void pushWaiter(StepAwaiter* awaiter) {
+        m_waiters.push_back(awaiter);
+        std::push_heap(m_waiters.begin(), m_waiters.end(), laterWake);
+    }
+
+    void resumeReady() {
+        std::vector<std::coroutine_handle<Task::promise_type>> ready;
+        ready.swap(m_ready);
+        for (std::coroutine_handle<Task::promise_type> handle : ready) {
+            handle.resume();
+            if (!handle.done()) {
+                continue;
+            }
+            std::exception_ptr exception = handle.promise().exception;
+            m_tasks.erase(std::find(m_tasks.begin(), m_tasks.end(), handle));
+            handle.destroy();
+            if (exception) {
+                // Loops taken in this round but not resumed yet stay ready
+                m_ready.insert(m_ready.end(), std::find(ready.begin(), ready.end(), handle) + 1, ready.end());
+                std::rethrow_exception(exception);
+            }
+        }
+    }
+
+    TimeFunction m_getCurrentTimeFunc;
+    SleepFunction m_sleepFunc;
+    eerratic_tick_t m_pollInterval;
+    std::vector<std::coroutine_handle<Task::promise_type>> m_tasks;
+    std::vector<std::coroutine_handle<Task::promise_type>> m_ready;
+    std::vector<StepAwaiter*> m_waiters;
+};
+
+#endif // EERRATIC_COROUTINE_HPP
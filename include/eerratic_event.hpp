@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_EVENT_HPP
+#define EERRATIC_EVENT_HPP
+
+#include "eerratic_timer.h"
+
+#include <atomic>
+#include <cstdint>
+
+#if defined(__linux__) && !defined(EERRATIC_EVENT_NO_FUTEX)
+#define EERRATIC_EVENT_USE_FUTEX 1
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+
+/**
+ * @brief Manual-reset event signalled by producers and waited on in the kernel
+ *
+ * set() wakes every waiter; the event stays set until clear(). wait() parks
+ * the thread in a futex timed wait on Linux and a condition variable
+ * elsewhere, so a blocked step uses no CPU and wakes right after set().
+ * isSet() is a single atomic load.
+ *
+ * Plug it into a WAIT_EVENT / WAIT_TIME_AND_EVENT step with WAIT_POLICY_BLOCK:
+ * isSetCtx / waitCtx for timer_utils_ctx_t, or the EEerraticTimer::addStep
+ * overload taking an event. Bare-metal builds keep using a polled
+ * is_event_set_func and do not need this header.
+ */
+class EEerraticEvent {
+public:
+    EEerraticEvent() = default;
+
+    EEerraticEvent(const EEerraticEvent&) = delete;
+    EEerraticEvent& operator=(const EEerraticEvent&) = delete;
+
+    void set();
+    // Set and record when the event fired, in the waiting timer's clock
+    void set(eerratic_tick_t firedTime);
+    void clear() { m_state.store(0, std::memory_order_release); }
+    bool isSet() const { return m_state.load(std::memory_order_acquire) != 0; }
+
+    /**
+     * @brief Get the time passed to set(firedTime)
+     *
+     * @return false if the event is not set or was set without a time
+     */
+    bool getFiredTime(eerratic_tick_t& firedTime) const;
+
+    /**
+     * @brief Wait until the event is set, at most timeout ticks
+     *
+     * @return true if the event is set afterwards
+     */
+    bool wait(eerratic_tick_t timeout);
+
+    static bool isSetCtx(void* ctx) {
+        return static_cast<const EEerraticEvent*>(ctx)->isSet();
+    }
+
+    static bool waitCtx(void* ctx, eerratic_tick_t timeout) {
+        return static_cast<EEerraticEvent*>(ctx)->wait(timeout);
+    }
+
+private:
+    void signal();
+
+    std::atomic<uint32_t> m_state{ 0 };
+    // set() only enters the kernel when someone is waiting
+    std::atomic<uint32_t> m_waiters{ 0 };
+    std::atomic<eerratic_tick_t> m_firedTime{ 0 };
+    std::atomic<bool> m_hasFiredTime{ false };
+#ifndef EERRATIC_EVENT_USE_FUTEX
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+#endif
+};
+
+#endif // EERRATIC_EVENT_HPP
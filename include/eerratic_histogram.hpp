@@ -0,0 +1,127 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_HISTOGRAM_HPP
+#define EERRATIC_HISTOGRAM_HPP
+
+#include "eerratic_timer.h"
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+
+/**
+ * @brief Fixed-memory, log-bucketed (HDR-style) histogram of tick values
+ *
+ * Values below 2^kSubBucketBits are recorded exactly. Larger values are
+ * grouped by their most significant bit and split into 2^kSubBucketBits
+ * linear sub-buckets, so every bucket is accurate to 1/16 of its value.
+ * Recording is O(1) and never allocates.
+ */
+class EEerraticHistogram {
+public:
+    static constexpr unsigned kSubBucketBits = 4;
+    static constexpr unsigned kSubBucketCount = 1u << kSubBucketBits;
+    static constexpr unsigned kTickBits = std::numeric_limits<eerratic_tick_t>::digits;
+    static constexpr unsigned kBucketCount = (kTickBits - kSubBucketBits + 1) * kSubBucketCount;
+
+    void record(eerratic_tick_t value) {
+        m_counts[bucketIndex(value)]++;
+        m_totalCount++;
+        if (value > m_max) {
+            m_max = value;
+        }
+        if (value < m_min) {
+            m_min = value;
+        }
+    }
+
+    void reset() {
+        m_counts.fill(0);
+        m_totalCount = 0;
+        m_min = std::numeric_limits<eerratic_tick_t>::max();
+        m_max = 0;
+    }
+
+    uint64_t getTotalCount() const { return m_totalCount; }
+    eerratic_tick_t getMin() const { return m_totalCount ? m_min : 0; }
+    eerratic_tick_t getMax() const { return m_max; }
+
+    /**
+     * @brief Get the value at the given percentile
+     *
+     * @param percentile Percentile in [0, 100]
+     * @return eerratic_tick_t Upper bound of the bucket holding the percentile, clamped to the max
+     */
+    eerratic_tick_t getValueAtPercentile(double percentile) const {
+        if (m_totalCount == 0) {
+            return 0;
+        }
+        if (percentile < 0.0) {
+            percentile = 0.0;
+        }
+        uint64_t rank = static_cast<uint64_t>(percentile / 100.0 * static_cast<double>(m_totalCount) + 0.5);
+        if (rank == 0) {
+            rank = 1;
+        }
+        if (rank > m_totalCount) {
+            rank = m_totalCount;
+        }
+
+        uint64_t seen = 0;
+        for (unsigned i = 0; i < kBucketCount; i++) {
+            seen += m_counts[i];
+            if (seen >= rank) {
+                eerratic_tick_t upper = bucketUpperBound(i);
+                return upper < m_max ? upper : m_max;
+            }
+        }
+        return m_max;
+    }
+
+    static unsigned bucketIndex(eerratic_tick_t value) {
+        if (value < kSubBucketCount) {
+            return static_cast<unsigned>(value);
+        }
+        unsigned msb = highestBit(value);
+        unsigned shift = msb - kSubBucketBits;
+        return (shift + 1) * kSubBucketCount + static_cast<unsigned>((value >> shift) & (kSubBucketCount - 1));
+    }
+
+    static eerratic_tick_t bucketUpperBound(unsigned index) {
+        if (index < kSubBucketCount) {
+            return static_cast<eerratic_tick_t>(index);
+        }
+        unsigned shift = index / kSubBucketCount - 1;
+        eerratic_tick_t base = static_cast<eerratic_tick_t>(kSubBucketCount | (index % kSubBucketCount)) << shift;
+        return base + ((static_cast<eerratic_tick_t>(1) << shift) - 1);
+    }
+
+private:
+    static unsigned highestBit(eerratic_tick_t value) {
+        unsigned bit = 0;
+#if defined(__GNUC__) || defined(__clang__)
+        if (sizeof(eerratic_tick_t) == sizeof(unsigned long long)) {
+            bit = kTickBits - 1 - static_cast<unsigned>(__builtin_clzll(static_cast<unsigned long long>(value)));
+        } else {
+            bit = kTickBits - 1 - static_cast<unsigned>(__builtin_clz(static_cast<unsigned>(value)));
+        }
+#else
+        while (value >>= 1) {
+            bit++;
+        }
+#endif
+        return bit;
+    }
+
+    std::array<uint64_t, kBucketCount> m_counts{};
+    uint64_t m_totalCount = 0;
+    eerratic_tick_t m_min = std::numeric_limits<eerratic_tick_t>::max();
+    eerratic_tick_t m_max = 0;
+};
+
+#endif // EERRATIC_HISTOGRAM_HPP
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_METRICS_HPP
+#define EERRATIC_METRICS_HPP
+
+#include "eerratic_timer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+
+/*
+ * Layout of the shared metrics file. All values are 64-bit ticks of
+ * ticksPerSec, independent of the time base of the reader. Every step slot
+ * (and the loop block) is guarded by its own sequence counter: the writer
+ * makes it odd while updating, readers retry until they see the same even
+ * value before and after copying. The writer never waits for readers; a
+ * reader stops retrying a slot that stays odd (a writer that died mid-update)
+ * and reports it as torn.
+ */
+static constexpr uint32_t kEEerraticMetricsMagic = 0x45454d54u;   // "EEMT"
+static constexpr uint32_t kEEerraticMetricsVersion = 1;
+
+struct alignas(64) EEerraticMetricsHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t stepCapacity;
+    std::atomic<uint32_t> stepCount;        // Slots in use
+    uint64_t ticksPerSec;
+    std::atomic<uint32_t> loopSeq;
+    std::atomic<uint64_t> loopCount;
+    std::atomic<uint64_t> loopOverrunCount;
+    std::atomic<uint64_t> lastLoopElapsed;
+    std::atomic<uint64_t> maxLoopElapsed;
+};
+
+struct alignas(64) EEerraticMetricsStep {
+    std::atomic<uint32_t> seq;
+    std::atomic<int32_t> stepId;
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> timeoutCount;     // ERROR_CODE_TIMEOUT / ERROR_CODE_TOTAL_TIMEOUT results
+    std::atomic<uint64_t> lastElapsed;
+    std::atomic<uint64_t> maxElapsed;
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared metrics need lock-free 64-bit atomics");
+
+/**
+ * @brief Publishes step and loop metrics into a memory-mapped file
+ *
+ * Attach it with EEerraticTimer::setMetricsExporter(); the timer thread is
+ * the only writer. Each update is a handful of relaxed stores, with no lock
+ * and no system call, so another process can watch the loop through
+ * EEerraticMetricsReader at no cost to it.
+ */
+class EEerraticMetricsExporter {
+public:
+    EEerraticMetricsExporter(const std::string& path, uint32_t stepCapacity);
+    ~EEerraticMetricsExporter();
+
+    EEerraticMetricsExporter(const EEerraticMetricsExporter&) = delete;
+    EEerraticMetricsExporter& operator=(const EEerraticMetricsExporter&) = delete;
+
+    // Slots beyond the capacity are ignored
+    void recordStep(uint32_t slot, int stepId, eerratic_tick_t elapsed, ERROR_CODE result);
+    void recordLoop(eerratic_tick_t elapsed, bool overrun);
+
+private:
+    EEerraticMetricsHeader* m_header = nullptr;
+    EEerraticMetricsStep* m_steps = nullptr;
+    size_t m_size = 0;
+};
+
+/**
+ * @brief Reads a metrics file published by EEerraticMetricsExporter, from any process
+ */
+class EEerraticMetricsReader {
+public:
+    struct StepSnapshot {
+        int32_t stepId;
+        uint64_t count;
+        uint64_t timeoutCount;
+        uint64_t lastElapsed;
+        uint64_t maxElapsed;
+        bool torn;                          // No consistent copy: the writer never finished its update
+    };
+
+    struct LoopSnapshot {
+        uint64_t loopCount;
+        uint64_t loopOverrunCount;
+        uint64_t lastLoopElapsed;
+        uint64_t maxLoopElapsed;
+        bool torn;                          // As in StepSnapshot
+    };
+
+    explicit EEerraticMetricsReader(const std::string& path);
+    ~EEerraticMetricsReader();
+
+    EEerraticMetricsReader(const EEerraticMetricsReader&) = delete;
+    EEerraticMetricsReader& operator=(const EEerraticMetricsReader&) = delete;
+
+    uint64_t getTicksPerSec() const;
+    uint32_t getStepCount() const;
+    bool readStep(uint32_t slot, StepSnapshot&) const;
+    LoopSnapshot readLoop() const;
+
+private:
+    const EEerraticMetricsHeader* m_header = nullptr;
+    const EEerraticMetricsStep* m_steps = nullptr;
+    size_t m_size = 0;
+    uint32_t m_stepCapacity = 0;        // Checked against m_size when opened
+};
+
+#endif // EERRATIC_METRICS_HPP
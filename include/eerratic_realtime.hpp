@@ -0,0 +1,68 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_REALTIME_HPP
+#define EERRATIC_REALTIME_HPP
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+
+/**
+ * @brief Scheduling setup of a timer thread (Linux)
+ *
+ * Deadline accuracy depends on how the waiting thread is scheduled: apply()
+ * pins it to CPUs, switches it to SCHED_FIFO, shortens its timer slack, locks
+ * the process memory and pre-faults its stack. Every setting is optional and
+ * is read back after being applied; a setting that needs privileges the
+ * process lacks is reported as Failed and the rest still apply, so the same
+ * code runs unprivileged with looser jitter.
+ *
+ * Call apply() on the thread that runs EEerraticTimer; EEerraticScheduler
+ * applies it to its workers with setRealtimeConfig().
+ */
+class EEerraticRealtime {
+public:
+    struct Config {
+        std::vector<int> cpus;              // CPUs to run on (empty: unchanged)
+        int fifoPriority = 0;               // SCHED_FIFO priority 1..99 (0: unchanged)
+        unsigned long timerSlackNs = 0;     // Timer slack in ns, e.g. 1 (0: unchanged)
+        bool lockMemory = false;            // mlockall() current and future pages
+        size_t prefaultStackBytes = 0;      // Stack to touch so it never page faults later (clamped to the stack left)
+    };
+
+    enum class Status {
+        NotRequested,
+        Applied,                            // Set and verified
+        Partial,                            // Applied to less than requested; see error
+        Failed,                             // Rejected, usually for lack of privileges; see error
+        Unsupported                         // Not available on this platform
+    };
+
+    struct Setting {
+        Status status = Status::NotRequested;
+        int error = 0;                      // errno of the failed call, ENOMEM for a clamped stack prefault
+    };
+
+    struct Report {
+        Setting affinity;
+        Setting priority;
+        Setting timerSlack;
+        Setting memoryLock;
+        Setting stackPrefault;
+
+        // True when every requested setting took effect
+        bool allApplied() const;
+        // One line per requested setting, e.g. "priority: failed (Operation not permitted)"
+        std::string describe() const;
+    };
+
+    // Applies the config to the calling thread (and memory locking to the process)
+    static Report apply(const Config&);
+};
+
+#endif // EERRATIC_REALTIME_HPP
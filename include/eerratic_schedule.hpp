@@ -0,0 +1,230 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_SCHEDULE_HPP
+#define EERRATIC_SCHEDULE_HPP
+
+#include "eerratic_timer.h"
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+
+/**
+ * @brief Budget of a SLEEP_REMAINING_TIME(_PRECISE) step that sleeps until the end of the loop
+ *
+ * Such a step is excluded from the budget sum and must be the last step.
+ */
+constexpr eerratic_tick_t EERRATIC_LOOP_REMAINDER = std::numeric_limits<eerratic_tick_t>::max();
+
+/**
+ * @brief Compile-time step declaration for EEerraticSchedule
+ *
+ * Supports WAIT_EVENT, WAIT_TIME_AND_EVENT, SLEEP_REMAINING_TIME and
+ * SLEEP_REMAINING_TIME_PRECISE. WAIT_ANY_EVENT and WAIT_ALL_EVENTS steps need
+ * an event set and are not supported; use EEerraticTimer for them.
+ *
+ * @tparam SleepType The sleep type of the step
+ * @tparam ExpectedElapsedTime The budget of the step (or EERRATIC_LOOP_REMAINDER)
+ * @tparam IsEventSetFunc The event function (required for WAIT_EVENT / WAIT_TIME_AND_EVENT)
+ * @tparam WaitPolicy The wait policy used while waiting for the event (and while
+ *         spinning to the deadline of a SLEEP_REMAINING_TIME_PRECISE step)
+ * @tparam YieldFunc The yield function (required for WAIT_POLICY_YIELD, used by WAIT_POLICY_ADAPTIVE)
+ * @tparam WaitEventFunc The wait-event function of WAIT_POLICY_BLOCK / WAIT_POLICY_ADAPTIVE
+ *         (optional, without it the wait sleeps in slices of EERRATIC_BLOCK_SLICE)
+ */
+template <sleep_type_t SleepType,
+          eerratic_tick_t ExpectedElapsedTime,
+          is_event_set_func_t IsEventSetFunc = nullptr,
+          wait_policy_t WaitPolicy = WAIT_POLICY_SPIN,
+          yield_func_t YieldFunc = nullptr,
+          wait_event_func_t WaitEventFunc = nullptr>
+struct EEerraticStep {
+    static constexpr sleep_type_t sleepType = SleepType;
+    static constexpr eerratic_tick_t expectedElapsedTime = ExpectedElapsedTime;
+    static constexpr is_event_set_func_t isEventSetFunc = IsEventSetFunc;
+    static constexpr wait_policy_t waitPolicy = WaitPolicy;
+    static constexpr yield_func_t yieldFunc = YieldFunc;
+    static constexpr wait_event_func_t waitEventFunc = WaitEventFunc;
+
+    static constexpr bool isSleep = SleepType == SLEEP_REMAINING_TIME || SleepType == SLEEP_REMAINING_TIME_PRECISE;
+
+    static_assert(SleepType != WAIT_ANY_EVENT && SleepType != WAIT_ALL_EVENTS,
+                  "WAIT_ANY_EVENT and WAIT_ALL_EVENTS steps are not supported by EEerraticSchedule");
+    static_assert(isSleep || IsEventSetFunc != nullptr,
+                  "WAIT_EVENT and WAIT_TIME_AND_EVENT steps need an event function");
+    static_assert(ExpectedElapsedTime != EERRATIC_LOOP_REMAINDER || isSleep,
+                  "only SLEEP_REMAINING_TIME(_PRECISE) steps may use EERRATIC_LOOP_REMAINDER");
+    static_assert(WaitPolicy != WAIT_POLICY_YIELD || YieldFunc != nullptr,
+                  "WAIT_POLICY_YIELD steps need a yield function");
+};
+
+/**
+ * @brief Loop schedule fixed at compile time
+ *
+ * The steps, their budgets and all callbacks are template parameters, so
+ * every step compiles to a direct, inlinable call into the eerratic_sleep
+ * primitives with no lookup table, no heap and no indirect calls.
+ * The step budgets are checked against the loop period with static_assert.
+ *
+ * @tparam LoopExpectedElapsedTime The expected elapsed time of the loop
+ * @tparam GetCurrentTimeFunc The function to get the current time
+ * @tparam SleepFunc The function to sleep
+ * @tparam Steps The EEerraticStep declarations, in execution order
+ */
+template <eerratic_tick_t LoopExpectedElapsedTime,
+          get_current_time_func_t GetCurrentTimeFunc,
+          sleep_func_t SleepFunc,
+          typename... Steps>
+class EEerraticSchedule {
+public:
+    static constexpr std::size_t kStepCount = sizeof...(Steps);
+
+    static_assert(kStepCount > 0, "a schedule needs at least one step");
+    static_assert(GetCurrentTimeFunc != nullptr, "get_current_time_func is null");
+    static_assert(SleepFunc != nullptr, "sleep_func is null");
+
+private:
+    static constexpr eerratic_tick_t kBudgets[kStepCount] = { Steps::expectedElapsedTime... };
+
+    static constexpr eerratic_tick_t budgetSum() {
+        eerratic_tick_t sum = 0;
+        for (std::size_t i = 0; i < kStepCount; i++) {
+            if (kBudgets[i] == EERRATIC_LOOP_REMAINDER) {
+                continue;
+            }
+            if (kBudgets[i] > LoopExpectedElapsedTime - sum) {
+                return EERRATIC_LOOP_REMAINDER;
+            }
+            sum += kBudgets[i];
+        }
+        return sum;
+    }
+
+    static constexpr bool remainderIsLast() {
+        for (std::size_t i = 0; i + 1 < kStepCount; i++) {
+            if (kBudgets[i] == EERRATIC_LOOP_REMAINDER) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+public:
+    static constexpr eerratic_tick_t kBudgetSum = budgetSum();
+
+    static_assert(kBudgetSum <= LoopExpectedElapsedTime, "step budgets exceed the loop expected elapsed time");
+    static_assert(remainderIsLast(), "EERRATIC_LOOP_REMAINDER is only allowed on the last step");
+
+    /**
+     * @brief Time left in the loop once every budgeted step used its full budget
+     */
+    static constexpr eerratic_tick_t kHeadroom = LoopExpectedElapsedTime - kBudgetSum;
+
+    void resetLoop() {
+        m_loopStartTime = GetCurrentTimeFunc();
+    }
+
+    /**
+     * @brief Execute the sleep of step I
+     *
+     * @tparam I The index of the step
+     * @return ERROR_CODE 
+     */
+    template <std::size_t I>
+    ERROR_CODE executeSleep() {
+        static_assert(I < kStepCount, "step index out of range");
+        using Step = std::tuple_element_t<I, std::tuple<Steps...>>;
+
+        constexpr eerratic_tick_t expectedElapsedTime =
+            (Step::expectedElapsedTime == EERRATIC_LOOP_REMAINDER) ? LoopExpectedElapsedTime : Step::expectedElapsedTime;
+        constexpr wait_backend_t waitBackend = { Step::waitPolicy, Step::yieldFunc, Step::waitEventFunc };
+        eerratic_tick_t* elapsedTime = &m_elapsedTimes[I];
+
+        if constexpr (Step::sleepType == WAIT_EVENT) {
+            return wait_timeout_or_event_with_backend(
+                m_loopStartTime, LoopExpectedElapsedTime, expectedElapsedTime, elapsedTime,
+                GetCurrentTimeFunc, Step::isEventSetFunc, SleepFunc, &waitBackend);
+        } else if constexpr (Step::sleepType == WAIT_TIME_AND_EVENT) {
+            return wait_time_and_event_with_backend(
+                m_loopStartTime, LoopExpectedElapsedTime, expectedElapsedTime, elapsedTime,
+                GetCurrentTimeFunc, Step::isEventSetFunc, SleepFunc, &waitBackend);
+        } else if constexpr (Step::sleepType == SLEEP_REMAINING_TIME_PRECISE) {
+            legacy_funcs_t funcs = { GetCurrentTimeFunc, nullptr, SleepFunc, nullptr, nullptr };
+            timer_utils_ctx_t timerUtils = make_legacy_timer_utils_ctx(&funcs, &waitBackend);
+            timerUtils.precise_sleep = &m_preciseSleeps[I];
+            sleep_remaining_time_precise_ctx(
+                m_loopStartTime, LoopExpectedElapsedTime, expectedElapsedTime, elapsedTime, &timerUtils);
+            return ERROR_CODE_OK;
+        } else {
+            sleep_remaining_time(
+                m_loopStartTime, LoopExpectedElapsedTime, expectedElapsedTime, elapsedTime,
+                GetCurrentTimeFunc, SleepFunc);
+            return ERROR_CODE_OK;
+        }
+    }
+
+    /**
+     * @brief Run one loop: reset it, then for every step call body(index) followed by its sleep
+     *
+     * @param body Called with std::integral_constant<std::size_t, I> before step I sleeps
+     * @return ERROR_CODE ERROR_CODE_OK, or the first error returned by a step
+     */
+    template <typename Body>
+    ERROR_CODE runLoop(Body&& body) {
+        resetLoop();
+        return runSteps(body, std::make_index_sequence<kStepCount>{});
+    }
+
+    template <std::size_t I>
+    eerratic_tick_t getElapsedTime() const {
+        static_assert(I < kStepCount, "step index out of range");
+        return m_elapsedTimes[I];
+    }
+
+    eerratic_tick_t getLoopStartTime() const {
+        return m_loopStartTime;
+    }
+
+    // Learned margin and deadline error of a SLEEP_REMAINING_TIME_PRECISE step
+    template <std::size_t I>
+    const precise_sleep_t& getPreciseSleepState() const {
+        static_assert(I < kStepCount, "step index out of range");
+        return m_preciseSleeps[I];
+    }
+
+private:
+    template <typename Body, std::size_t... I>
+    ERROR_CODE runSteps(Body& body, std::index_sequence<I...>) {
+        ERROR_CODE result = ERROR_CODE_OK;
+        ((static_cast<void>(body(std::integral_constant<std::size_t, I>{})), recordFirstError(result, executeSleep<I>())), ...);
+        return result;
+    }
+
+    static void recordFirstError(ERROR_CODE& result, ERROR_CODE stepResult) {
+        if (result == ERROR_CODE_OK) {
+            result = stepResult;
+        }
+    }
+
+    static std::array<precise_sleep_t, kStepCount> initialPreciseSleeps() {
+        std::array<precise_sleep_t, kStepCount> states{};
+        for (precise_sleep_t& state : states) {
+            precise_sleep_init(&state);
+        }
+        return states;
+    }
+
+    eerratic_tick_t m_loopStartTime = 0;
+    std::array<eerratic_tick_t, kStepCount> m_elapsedTimes{};
+    std::array<precise_sleep_t, kStepCount> m_preciseSleeps = initialPreciseSleeps();
+};
+
+#endif // EERRATIC_SCHEDULE_HPP
@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_SCHEDULER_HPP
+#define EERRATIC_SCHEDULER_HPP
+
+#include "eerratic_callback.hpp"
+#include "eerratic_realtime.hpp"
+#include "eerratic_timer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Runs many periodic loops on a small pool of worker threads
+ *
+ * Every loop is a list of steps with the same semantics as
+ * EEerraticTimer::executeSleep, executed in the order they were added and
+ * restarted (like resetLoop()) once the last step completes. Instead of one
+ * blocked thread per loop, pending steps sit in a deadline-ordered heap and
+ * the workers park until the earliest deadline, so thread count scales with
+ * the pool size rather than with the number of loops.
+ *
+ * Steps waiting for an event are re-polled every pollInterval ticks, or
+ * immediately after notify(). The clock must advance at EERRATIC_TICKS_PER_SEC.
+ */
+class EEerraticScheduler {
+public:
+    using TimeFunction = EEerraticCallback<eerratic_tick_t()>;
+    using EventFunction = EEerraticCallback<bool()>;
+    // Called on a worker thread when a step completes: (step id, result, elapsed time)
+    using StepDoneFunction = EEerraticCallback<void(int, ERROR_CODE, eerratic_tick_t)>;
+
+    struct LoopHandle {
+        uint32_t index;
+    };
+
+    EEerraticScheduler(size_t, TimeFunction, eerratic_tick_t = EERRATIC_TICKS_PER_MS);
+    ~EEerraticScheduler();
+
+    EEerraticScheduler(const EEerraticScheduler&) = delete;
+    EEerraticScheduler& operator=(const EEerraticScheduler&) = delete;
+
+    LoopHandle addLoop(eerratic_tick_t, StepDoneFunction = nullptr);
+    void addStep(LoopHandle, int, eerratic_tick_t, EventFunction, sleep_type_t);
+    // Applied by every worker before it runs steps. With several cpus, worker i is
+    // pinned to cpus[i % cpus.size()] alone. Must be set before start().
+    void setRealtimeConfig(const EEerraticRealtime::Config&);
+    void start();
+    void stop();
+    void notify();
+    uint64_t getLoopCount(LoopHandle) const;
+    uint64_t getTimeoutCount(LoopHandle) const;
+    size_t getWorkerCount() const;
+    // What took effect on each worker; filled by start()
+    std::vector<EEerraticRealtime::Report> getRealtimeReports() const;
+
+private:
+    struct Step {
+        int id;
+        eerratic_tick_t expectedElapsedTime;
+        EventFunction isEventSetFunc;
+        sleep_type_t sleepType;
+    };
+
+    struct Loop {
+        eerratic_tick_t loopExpectedElapsedTime = 0;
+        eerratic_tick_t loopStartTime = 0;
+        std::vector<Step> steps;
+        StepDoneFunction onStepDone;
+        size_t stepIndex = 0;
+        step_poll_t poll{};
+        std::atomic<uint64_t> loopCount{0};
+        std::atomic<uint64_t> timeoutCount{0};
+    };
+
+    struct Entry {
+        eerratic_tick_t wakeTime;
+        uint32_t loopIndex;
+        bool waitsForEvent;
+    };
+
+    void workerMain();
+    void applyRealtime(size_t);
+    Entry runLoop(uint32_t, eerratic_tick_t);
+    void pushEntry(const Entry&);
+    Loop& loopAt(LoopHandle) const;
+
+    TimeFunction m_getCurrentTimeFunc;
+    eerratic_tick_t m_pollInterval;
+    size_t m_workerCount;
+
+    std::vector<std::unique_ptr<Loop>> m_loops;
+    std::vector<Entry> m_queue;
+    std::vector<std::thread> m_workers;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_running = false;
+
+    bool m_hasRealtimeConfig = false;
+    EEerraticRealtime::Config m_realtimeConfig;
+    std::vector<EEerraticRealtime::Report> m_realtimeReports;
+    std::mutex m_realtimeMutex;
+    std::condition_variable m_realtimeCv;
+    size_t m_realtimeApplied = 0;
+    bool m_hasTimedWaiter = false;
+};
+
+#endif // EERRATIC_SCHEDULER_HPP
@@ -20,6 +20,8 @@ extern "C" {
 typedef enum ERROR_CODE
 {
     ERROR_CODE_OK = 0,
+    ERROR_CODE_PENDING = 1,
+    ERROR_CODE_SHED = 2,
     ERROR_CODE_TIMEOUT = -1,
     ERROR_CODE_NULL_POINTER = -2,
     ERROR_CODE_TOTAL_TIMEOUT = -3,
@@ -27,27 +29,199 @@ typedef enum ERROR_CODE
     ERROR_CODE_UNKNOWN = -5
 } ERROR_CODE;
 
-typedef uint32_t (*get_current_time_func_t)(void);
-typedef void (*sleep_func_t)(uint32_t);
+/*
+ * Time base selection. All times handled by this header are expressed in
+ * eerratic_tick_t units of the selected base. Define EERRATIC_TIME_BASE
+ * before including this header (identically in every translation unit).
+ * Durations are always computed as unsigned differences, so timestamps may
+ * wrap around freely.
+ */
+#define EERRATIC_TIME_BASE_MS32 0
+#define EERRATIC_TIME_BASE_US64 1
+#define EERRATIC_TIME_BASE_NS64 2
+
+#ifndef EERRATIC_TIME_BASE
+#define EERRATIC_TIME_BASE EERRATIC_TIME_BASE_MS32
+#endif
+
+#if EERRATIC_TIME_BASE == EERRATIC_TIME_BASE_MS32
+typedef uint32_t eerratic_tick_t;
+#define EERRATIC_TICKS_PER_SEC 1000u
+#elif EERRATIC_TIME_BASE == EERRATIC_TIME_BASE_US64
+typedef uint64_t eerratic_tick_t;
+#define EERRATIC_TICKS_PER_SEC 1000000u
+#elif EERRATIC_TIME_BASE == EERRATIC_TIME_BASE_NS64
+typedef uint64_t eerratic_tick_t;
+#define EERRATIC_TICKS_PER_SEC 1000000000u
+#else
+#error "Unsupported EERRATIC_TIME_BASE"
+#endif
+
+#define EERRATIC_TICKS_PER_MS (EERRATIC_TICKS_PER_SEC / 1000u)
+#define EERRATIC_MS_TO_TICKS(ms) ((eerratic_tick_t)(ms) * EERRATIC_TICKS_PER_MS)
+
+typedef eerratic_tick_t (*get_current_time_func_t)(void);
+typedef void (*sleep_func_t)(eerratic_tick_t);
 typedef bool (*is_event_set_func_t)(void);
+typedef void (*yield_func_t)(void);
+typedef bool (*wait_event_func_t)(eerratic_tick_t);
+typedef uint32_t (*get_event_mask_func_t)(void);
+
+/* Number of polls the adaptive policy spins before it starts yielding */
+#ifndef EERRATIC_ADAPTIVE_SPIN_COUNT
+#define EERRATIC_ADAPTIVE_SPIN_COUNT 1000
+#endif
+
+/* Number of polls the adaptive policy yields before it starts blocking */
+#ifndef EERRATIC_ADAPTIVE_YIELD_COUNT
+#define EERRATIC_ADAPTIVE_YIELD_COUNT 100
+#endif
+
+/* Margin a precise sleep starts with before it has observed any sleep_func overshoot */
+#ifndef EERRATIC_PRECISE_INITIAL_MARGIN
+#define EERRATIC_PRECISE_INITIAL_MARGIN EERRATIC_TICKS_PER_MS
+#endif
 
+/* Upper bound of the learned precise sleep margin (the time spent spinning) */
+#ifndef EERRATIC_PRECISE_MAX_MARGIN
+#define EERRATIC_PRECISE_MAX_MARGIN (10 * EERRATIC_TICKS_PER_MS)
+#endif
+
+/* The learned margin shrinks by 1/2^shift of its excess over each observed overshoot */
+#ifndef EERRATIC_PRECISE_DECAY_SHIFT
+#define EERRATIC_PRECISE_DECAY_SHIFT 4
+#endif
+
+/* Longest single sleep_func call used to park when no wait_event_func is set */
+#ifndef EERRATIC_BLOCK_SLICE
+#define EERRATIC_BLOCK_SLICE EERRATIC_TICKS_PER_MS
+#endif
+
+typedef enum {
+    WAIT_POLICY_SPIN = 0,
+    WAIT_POLICY_YIELD,
+    WAIT_POLICY_BLOCK,
+    WAIT_POLICY_ADAPTIVE
+} wait_policy_t;
 
 typedef struct
 {
-    uint32_t elapsed_time; 
-    uint32_t expected_elapsed_time;
+    wait_policy_t policy;
+    yield_func_t yield_func;
+    wait_event_func_t wait_event_func;
+} wait_backend_t;
+
+/* Number of events a WAIT_ANY_EVENT / WAIT_ALL_EVENTS step can watch (bits of the event mask) */
+#define EERRATIC_MAX_EVENTS 32
+
+/*
+ * Events of a WAIT_ANY_EVENT / WAIT_ALL_EVENTS step. get_event_mask_func returns all
+ * events currently set as one bit mask (for example an atomic word), so a
+ * single call checks every source. An event counts as fired once it has
+ * been seen set during the step.
+ */
+typedef struct
+{
+    uint32_t wait_mask;                                 /* Events the step waits for */
+    uint32_t fired_mask;                                /* Events seen set, filled by the wait */
+    eerratic_tick_t fired_time[EERRATIC_MAX_EVENTS];    /* Step elapsed time when each event was first seen */
+} event_set_t;
+
+typedef struct
+{
+    eerratic_tick_t elapsed_time; 
+    eerratic_tick_t expected_elapsed_time;
     get_current_time_func_t get_current_time_func;
     is_event_set_func_t is_event_set_func;
     sleep_func_t sleep_func;
 } timer_utils_t;
 
+/*
+ * Context-carrying variants of the callbacks. Each callback receives the
+ * context pointer stored next to it in timer_utils_ctx_t, so independent
+ * timers can share one implementation without global state.
+ */
+typedef eerratic_tick_t (*get_current_time_ctx_func_t)(void*);
+typedef void (*sleep_ctx_func_t)(void*, eerratic_tick_t);
+typedef bool (*is_event_set_ctx_func_t)(void*);
+typedef bool (*wait_event_ctx_func_t)(void*, eerratic_tick_t);
+typedef uint32_t (*get_event_mask_ctx_func_t)(void*);
+
+typedef struct
+{
+    wait_policy_t policy;
+    yield_func_t yield_func;
+    wait_event_ctx_func_t wait_event_func;
+    void* wait_event_ctx;
+} wait_backend_ctx_t;
+
+/*
+ * State of SLEEP_REMAINING_TIME_PRECISE: the margin before the deadline at
+ * which the coarse sleep_func call ends and spinning takes over, learned from
+ * the overshoot of previous sleeps, and the achieved deadline error.
+ */
+typedef struct
+{
+    eerratic_tick_t margin;
+    eerratic_tick_t last_error;     /* How late the last precise sleep returned */
+    eerratic_tick_t max_error;
+    uint32_t count;
+} precise_sleep_t;
+
+typedef struct
+{
+    eerratic_tick_t elapsed_time;
+    eerratic_tick_t expected_elapsed_time;
+    get_current_time_ctx_func_t get_current_time_func;
+    is_event_set_ctx_func_t is_event_set_func;
+    sleep_ctx_func_t sleep_func;
+    void* time_ctx;
+    void* event_ctx;
+    void* sleep_ctx;
+    wait_backend_ctx_t wait_backend;
+    precise_sleep_t* precise_sleep;     /* Optional, learns the margin of SLEEP_REMAINING_TIME_PRECISE */
+    get_event_mask_ctx_func_t get_event_mask_func;  /* Events of WAIT_ANY_EVENT / WAIT_ALL_EVENTS */
+    void* event_mask_ctx;
+    event_set_t* event_set;
+} timer_utils_ctx_t;
+
 typedef enum {
     WAIT_EVENT,
     WAIT_TIME_AND_EVENT,
-    SLEEP_REMAINING_TIME
+    SLEEP_REMAINING_TIME,
+    SLEEP_REMAINING_TIME_PRECISE,
+    WAIT_ANY_EVENT,
+    WAIT_ALL_EVENTS
 } sleep_type_t;
 
 
+/**
+ * @brief Check if the timer is expired at a given time
+ * Both checks use the same clock reading, so a poll costs one clock read.
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param start_time The start time of the timer
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param current_time The current time
+ * @return ERROR_CODE 
+ */
+static inline ERROR_CODE check_timer_expired(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t start_time,
+    const eerratic_tick_t expected_elapsed_time,
+    const eerratic_tick_t current_time)
+{
+    if (current_time - loop_start_time >= loop_expected_elapsed_time) {
+        return ERROR_CODE_TOTAL_TIMEOUT;
+    } else if (current_time - start_time >= expected_elapsed_time) {
+        return ERROR_CODE_TIMEOUT;
+    } else {
+        return ERROR_CODE_OK;
+    }
+}
+
 /**
  * @brief Check if the timer is expired
  * 
@@ -59,10 +233,10 @@ typedef enum {
  * @return ERROR_CODE 
  */
 inline static ERROR_CODE is_timer_expired(
-    const uint32_t loop_start_time,
-    const uint32_t loop_expected_elapsed_time,
-    const uint32_t start_time,
-    const uint32_t expected_elapsed_time,
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t start_time,
+    const eerratic_tick_t expected_elapsed_time,
     get_current_time_func_t get_current_time_func)
 {
     if (get_current_time_func == NULL)
@@ -70,154 +244,439 @@ inline static ERROR_CODE is_timer_expired(
         return ERROR_CODE_NULL_POINTER;
     }
 
-    if (get_current_time_func() - loop_start_time >= loop_expected_elapsed_time) {
-        return ERROR_CODE_TOTAL_TIMEOUT;
-    } else if (get_current_time_func() - start_time >= expected_elapsed_time) {
-        return ERROR_CODE_TIMEOUT;
-    } else {
-        return ERROR_CODE_OK;
+    return check_timer_expired(loop_start_time, loop_expected_elapsed_time, start_time, expected_elapsed_time, get_current_time_func());
+}
+
+/**
+ * @brief Check if the timer is expired (context callbacks)
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param start_time The start time of the timer
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param timer_utils The callbacks and their contexts
+ * @return ERROR_CODE 
+ */
+static inline ERROR_CODE is_timer_expired_ctx(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t start_time,
+    const eerratic_tick_t expected_elapsed_time,
+    const timer_utils_ctx_t* timer_utils)
+{
+    if (timer_utils->get_current_time_func == NULL)
+    {
+        return ERROR_CODE_NULL_POINTER;
     }
+
+    return check_timer_expired(loop_start_time, loop_expected_elapsed_time, start_time, expected_elapsed_time, timer_utils->get_current_time_func(timer_utils->time_ctx));
 }
 
 /**
- * @brief Sleep the remaining time
+ * @brief Sleep the remaining time (context callbacks)
  * 
  * @param loop_start_time The start time of the loop
  * @param loop_expected_elapsed_time The expected elapsed time of the loop
  * @param expected_elapsed_time The expected elapsed time of the timer
  * @param elapsed_time The elapsed time
- * @param get_current_time_func The function to get the current time
- * @param sleep_func The function to sleep
+ * @param timer_utils The callbacks and their contexts
  */
-static inline void sleep_remaining_time(
-    const uint32_t loop_start_time,
-    const uint32_t loop_expected_elapsed_time,
-    const uint32_t expected_elapsed_time,
-    uint32_t* elapsed_time,
-    get_current_time_func_t get_current_time_func,
-    sleep_func_t sleep_func)
+static inline void sleep_remaining_time_ctx(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t expected_elapsed_time,
+    eerratic_tick_t* elapsed_time,
+    const timer_utils_ctx_t* timer_utils)
 {
-    if (get_current_time_func == NULL || sleep_func == NULL)
+    if (timer_utils->get_current_time_func == NULL || timer_utils->sleep_func == NULL)
     {
         return;
     }
 
-    uint32_t current_time = get_current_time_func();
+    eerratic_tick_t current_time = timer_utils->get_current_time_func(timer_utils->time_ctx);
     
     if (current_time - loop_start_time >= loop_expected_elapsed_time) {
         return;
     }
 
-    uint32_t remaining_time = expected_elapsed_time;
+    eerratic_tick_t remaining_time = expected_elapsed_time;
     remaining_time = (remaining_time > loop_expected_elapsed_time - (current_time - loop_start_time)) ? loop_expected_elapsed_time - (current_time - loop_start_time) : remaining_time;
 
     if (remaining_time > 0) {
-        sleep_func(remaining_time);
+        timer_utils->sleep_func(timer_utils->sleep_ctx, remaining_time);
     }
 
     if (elapsed_time != NULL) {
-        *elapsed_time = get_current_time_func() - current_time;
+        *elapsed_time = timer_utils->get_current_time_func(timer_utils->time_ctx) - current_time;
     }
     return;
 }
 
 
 /**
- * @brief Wait for the timeout or the event
+ * @brief Get the time left until the step or the loop expires, whichever comes first
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param start_time The start time of the timer
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param current_time The current time
+ * @return eerratic_tick_t The remaining time (0 if already expired)
+ */
+static inline eerratic_tick_t get_remaining_time(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t start_time,
+    const eerratic_tick_t expected_elapsed_time,
+    const eerratic_tick_t current_time)
+{
+    eerratic_tick_t loop_elapsed_time = current_time - loop_start_time;
+    eerratic_tick_t step_elapsed_time = current_time - start_time;
+
+    if (loop_elapsed_time >= loop_expected_elapsed_time || step_elapsed_time >= expected_elapsed_time) {
+        return 0;
+    }
+
+    eerratic_tick_t loop_remaining_time = loop_expected_elapsed_time - loop_elapsed_time;
+    eerratic_tick_t step_remaining_time = expected_elapsed_time - step_elapsed_time;
+    return (step_remaining_time < loop_remaining_time) ? step_remaining_time : loop_remaining_time;
+}
+
+/**
+ * @brief Initialize the state of precise sleeps
+ * 
+ * @param precise_sleep The state
+ */
+static inline void precise_sleep_init(precise_sleep_t* precise_sleep)
+{
+    precise_sleep->margin = EERRATIC_PRECISE_INITIAL_MARGIN;
+    precise_sleep->last_error = 0;
+    precise_sleep->max_error = 0;
+    precise_sleep->count = 0;
+}
+
+/**
+ * @brief Sleep the remaining time precisely (context callbacks)
+ * Sleeps with sleep_func until the learned margin before the deadline, then
+ * spins (or yields with WAIT_POLICY_YIELD) until the deadline itself. The
+ * margin grows at once when sleep_func overshoots past it and decays slowly
+ * otherwise; without timer_utils->precise_sleep the initial margin is used.
  * 
  * @param loop_start_time The start time of the loop
  * @param loop_expected_elapsed_time The expected elapsed time of the loop
  * @param expected_elapsed_time The expected elapsed time of the timer
  * @param elapsed_time The elapsed time
- * @param get_current_time_func The function to get the current time
- * @param is_event_set_func The function to check if the event is set
- * @return ERROR_CODE 
+ * @param timer_utils The callbacks, their contexts and the precise sleep state
  */
-static inline ERROR_CODE wait_timeout_or_event(
-    const uint32_t loop_start_time,
-    const uint32_t loop_expected_elapsed_time,
-    const uint32_t expected_elapsed_time,
-    uint32_t* elapsed_time,
-    get_current_time_func_t get_current_time_func,
-    is_event_set_func_t is_event_set_func)
+static inline void sleep_remaining_time_precise_ctx(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t expected_elapsed_time,
+    eerratic_tick_t* elapsed_time,
+    const timer_utils_ctx_t* timer_utils)
 {
-    if (get_current_time_func == NULL || is_event_set_func == NULL)
+    if (timer_utils->get_current_time_func == NULL || timer_utils->sleep_func == NULL)
     {
-        return ERROR_CODE_NULL_POINTER;
+        return;
     }
 
-    uint32_t start_time = get_current_time_func();
-    while (!is_event_set_func())
+    precise_sleep_t* precise_sleep = timer_utils->precise_sleep;
+    const eerratic_tick_t start_time = timer_utils->get_current_time_func(timer_utils->time_ctx);
+    const eerratic_tick_t deadline = start_time + get_remaining_time(loop_start_time, loop_expected_elapsed_time, start_time, expected_elapsed_time, start_time);
+    const eerratic_tick_t margin = (precise_sleep != NULL) ? precise_sleep->margin : EERRATIC_PRECISE_INITIAL_MARGIN;
+    eerratic_tick_t current_time = start_time;
+
+    if (deadline - start_time > margin)
     {
-        ERROR_CODE error_code = is_timer_expired(loop_start_time, loop_expected_elapsed_time, start_time, expected_elapsed_time, get_current_time_func);
-        if (error_code != ERROR_CODE_OK)
+        const eerratic_tick_t coarse_wake_time = deadline - margin;
+        timer_utils->sleep_func(timer_utils->sleep_ctx, coarse_wake_time - start_time);
+        current_time = timer_utils->get_current_time_func(timer_utils->time_ctx);
+
+        if (precise_sleep != NULL)
         {
-            if (elapsed_time != NULL)
-            {
-                *elapsed_time = get_current_time_func() - start_time;
+            const eerratic_tick_t overshoot = (current_time - start_time > coarse_wake_time - start_time) ? current_time - coarse_wake_time : 0;
+            eerratic_tick_t next_margin;
+            if (overshoot >= margin) {
+                next_margin = overshoot + overshoot / 2;
+            } else {
+                next_margin = margin - ((margin - overshoot) >> EERRATIC_PRECISE_DECAY_SHIFT);
             }
-            return ERROR_CODE_TIMEOUT;
+            precise_sleep->margin = (next_margin > EERRATIC_PRECISE_MAX_MARGIN) ? EERRATIC_PRECISE_MAX_MARGIN : next_margin;
         }
     }
 
+    while (current_time - start_time < deadline - start_time)
+    {
+        if (timer_utils->wait_backend.policy == WAIT_POLICY_YIELD && timer_utils->wait_backend.yield_func != NULL) {
+            timer_utils->wait_backend.yield_func();
+        }
+        current_time = timer_utils->get_current_time_func(timer_utils->time_ctx);
+    }
+
+    if (precise_sleep != NULL)
+    {
+        precise_sleep->last_error = current_time - deadline;
+        precise_sleep->max_error = (precise_sleep->last_error > precise_sleep->max_error) ? precise_sleep->last_error : precise_sleep->max_error;
+        precise_sleep->count++;
+    }
     if (elapsed_time != NULL)
     {
-        *elapsed_time = get_current_time_func() - start_time;
+        *elapsed_time = current_time - start_time;
+    }
+}
+
+/**
+ * @brief Park the calling thread until the event may be set or the deadline passes
+ * 
+ * Uses wait_event_func when available, otherwise sleeps in slices of
+ * EERRATIC_BLOCK_SLICE, otherwise yields.
+ * 
+ * @param remaining_time The time left until the deadline
+ * @param timer_utils The callbacks and their contexts
+ */
+static inline void wait_backend_block_ctx(
+    const eerratic_tick_t remaining_time,
+    const timer_utils_ctx_t* timer_utils)
+{
+    const wait_backend_ctx_t* wait_backend = &timer_utils->wait_backend;
+
+    if (wait_backend->wait_event_func != NULL) {
+        (void)wait_backend->wait_event_func(wait_backend->wait_event_ctx, remaining_time);
+    } else if (timer_utils->sleep_func != NULL) {
+        timer_utils->sleep_func(timer_utils->sleep_ctx, remaining_time < EERRATIC_BLOCK_SLICE ? remaining_time : EERRATIC_BLOCK_SLICE);
+    } else if (wait_backend->yield_func != NULL) {
+        wait_backend->yield_func();
+    }
+}
+
+/**
+ * @brief Wait until the event is set or the timer expires, following the wait policy
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param start_time The start time of the timer
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param timer_utils The callbacks, their contexts and the wait backend
+ * @return ERROR_CODE ERROR_CODE_OK if the event is set, ERROR_CODE_TIMEOUT otherwise
+ */
+static inline ERROR_CODE wait_event_with_backend_ctx(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t start_time,
+    const eerratic_tick_t expected_elapsed_time,
+    const timer_utils_ctx_t* timer_utils)
+{
+    const wait_backend_ctx_t* wait_backend = &timer_utils->wait_backend;
+    wait_policy_t policy = wait_backend->policy;
+    uint32_t poll_count = 0;
+
+    while (!timer_utils->is_event_set_func(timer_utils->event_ctx))
+    {
+        /* One clock read per poll serves the expiry check and the blocking wait */
+        const eerratic_tick_t current_time = timer_utils->get_current_time_func(timer_utils->time_ctx);
+        if (check_timer_expired(loop_start_time, loop_expected_elapsed_time, start_time, expected_elapsed_time, current_time) != ERROR_CODE_OK)
+        {
+            return ERROR_CODE_TIMEOUT;
+        }
+
+        if (policy == WAIT_POLICY_ADAPTIVE)
+        {
+            if (poll_count < EERRATIC_ADAPTIVE_SPIN_COUNT) {
+                poll_count++;
+                continue;
+            }
+            if (poll_count < EERRATIC_ADAPTIVE_SPIN_COUNT + EERRATIC_ADAPTIVE_YIELD_COUNT) {
+                poll_count++;
+                if (wait_backend->yield_func != NULL) {
+                    wait_backend->yield_func();
+                }
+                continue;
+            }
+        }
+
+        switch (policy)
+        {
+        case WAIT_POLICY_YIELD:
+            if (wait_backend->yield_func != NULL) {
+                wait_backend->yield_func();
+            }
+            break;
+        case WAIT_POLICY_BLOCK:
+        case WAIT_POLICY_ADAPTIVE:
+            wait_backend_block_ctx(
+                get_remaining_time(loop_start_time, loop_expected_elapsed_time, start_time, expected_elapsed_time, current_time),
+                timer_utils);
+            break;
+        case WAIT_POLICY_SPIN:
+        default:
+            break;
+        }
     }
     return ERROR_CODE_OK;
 }
 
 /**
- * @brief Wait for the timeout and the event
+ * @brief Wait for the timeout or the event (context callbacks)
  * 
  * @param loop_start_time The start time of the loop
  * @param loop_expected_elapsed_time The expected elapsed time of the loop
  * @param expected_elapsed_time The expected elapsed time of the timer
  * @param elapsed_time The elapsed time
- * @param get_current_time_func The function to get the current time
- * @param is_event_set_func The function to check if the event is set
- * @param sleep_func The function to sleep
+ * @param timer_utils The callbacks, their contexts and the wait backend
  * @return ERROR_CODE 
  */
-static inline ERROR_CODE wait_time_and_event(
-    const uint32_t loop_start_time,
-    const uint32_t loop_expected_elapsed_time,
-    const uint32_t expected_elapsed_time,
-    uint32_t* elapsed_time,
-    get_current_time_func_t get_current_time_func,
-    is_event_set_func_t is_event_set_func,
-    sleep_func_t sleep_func)
+static inline ERROR_CODE wait_timeout_or_event_ctx(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t expected_elapsed_time,
+    eerratic_tick_t* elapsed_time,
+    const timer_utils_ctx_t* timer_utils)
+{
+    if (timer_utils->get_current_time_func == NULL || timer_utils->is_event_set_func == NULL)
+    {
+        return ERROR_CODE_NULL_POINTER;
+    }
+
+    eerratic_tick_t start_time = timer_utils->get_current_time_func(timer_utils->time_ctx);
+    ERROR_CODE error_code = wait_event_with_backend_ctx(loop_start_time, loop_expected_elapsed_time, start_time, expected_elapsed_time, timer_utils);
+
+    if (elapsed_time != NULL)
+    {
+        *elapsed_time = timer_utils->get_current_time_func(timer_utils->time_ctx) - start_time;
+    }
+    return error_code;
+}
+
+/**
+ * @brief Wait for the timeout and the event (context callbacks)
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param elapsed_time The elapsed time
+ * @param timer_utils The callbacks, their contexts and the wait backend
+ * @return ERROR_CODE 
+ */
+static inline ERROR_CODE wait_time_and_event_ctx(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t expected_elapsed_time,
+    eerratic_tick_t* elapsed_time,
+    const timer_utils_ctx_t* timer_utils)
 {
-    if (get_current_time_func == NULL || is_event_set_func == NULL || sleep_func == NULL)
+    if (timer_utils->get_current_time_func == NULL || timer_utils->is_event_set_func == NULL || timer_utils->sleep_func == NULL)
     {
         return ERROR_CODE_NULL_POINTER;
     }
 
-    uint32_t start_time = get_current_time_func();
+    eerratic_tick_t start_time = timer_utils->get_current_time_func(timer_utils->time_ctx);
 
-    while (!is_event_set_func())
+    if (wait_event_with_backend_ctx(loop_start_time, loop_expected_elapsed_time, start_time, expected_elapsed_time, timer_utils) != ERROR_CODE_OK)
     {
-        if (is_timer_expired(loop_start_time, loop_expected_elapsed_time, start_time, expected_elapsed_time, get_current_time_func) != ERROR_CODE_OK)
+        if (elapsed_time != NULL)
         {
-            if (elapsed_time != NULL)
-            {
-                *elapsed_time = get_current_time_func() - start_time;
-            }
-            return ERROR_CODE_TIMEOUT;
+            *elapsed_time = timer_utils->get_current_time_func(timer_utils->time_ctx) - start_time;
         }
+        return ERROR_CODE_TIMEOUT;
     }
 
-    uint32_t remaining_time = expected_elapsed_time - (get_current_time_func() - start_time);
-    sleep_remaining_time(loop_start_time, loop_expected_elapsed_time, remaining_time, NULL, get_current_time_func, sleep_func);
+    eerratic_tick_t event_elapsed_time = timer_utils->get_current_time_func(timer_utils->time_ctx) - start_time;
+    eerratic_tick_t remaining_time = (event_elapsed_time < expected_elapsed_time) ? expected_elapsed_time - event_elapsed_time : 0;
+    sleep_remaining_time_ctx(loop_start_time, loop_expected_elapsed_time, remaining_time, NULL, timer_utils);
     if (elapsed_time != NULL)
     {
-        *elapsed_time = get_current_time_func() - start_time;
+        *elapsed_time = timer_utils->get_current_time_func(timer_utils->time_ctx) - start_time;
     }
     return ERROR_CODE_OK;
 }
 
+/*
+ * WAIT_ANY_EVENT / WAIT_ALL_EVENTS run the regular event wait with is_event_set_func
+ * pointed at event_set_poll(), which records newly fired events and tells
+ * whether the step condition holds.
+ */
+typedef struct
+{
+    const timer_utils_ctx_t* timer_utils;
+    eerratic_tick_t start_time;
+    bool wait_all;
+} event_set_poll_t;
+
+static inline bool event_set_poll(void* ctx)
+{
+    const event_set_poll_t* poll = (const event_set_poll_t*)ctx;
+    const timer_utils_ctx_t* timer_utils = poll->timer_utils;
+    event_set_t* event_set = timer_utils->event_set;
+    uint32_t new_mask = timer_utils->get_event_mask_func(timer_utils->event_mask_ctx) & event_set->wait_mask & ~event_set->fired_mask;
+
+    if (new_mask != 0)
+    {
+        const eerratic_tick_t fired_time = timer_utils->get_current_time_func(timer_utils->time_ctx) - poll->start_time;
+        uint32_t remaining_mask = new_mask;
+        uint32_t index;
+        for (index = 0; remaining_mask != 0; index++, remaining_mask >>= 1) {
+            if (remaining_mask & 1u) {
+                event_set->fired_time[index] = fired_time;
+            }
+        }
+        event_set->fired_mask |= new_mask;
+    }
+
+    if (poll->wait_all) {
+        return event_set->fired_mask == event_set->wait_mask;
+    }
+    return event_set->fired_mask != 0;
+}
+
 /**
- * @brief Sleep eerratic
+ * @brief Wait until any or all events of the event set fired, or the timeout (context callbacks)
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param elapsed_time The elapsed time
+ * @param timer_utils The callbacks, their contexts, the wait backend and the event set
+ * @param sleep_type WAIT_ANY_EVENT or WAIT_ALL_EVENTS
+ * @return ERROR_CODE ERROR_CODE_OK once the condition holds, ERROR_CODE_TIMEOUT otherwise;
+ *                    event_set->fired_mask tells which events fired in either case
+ */
+static inline ERROR_CODE wait_event_set_ctx(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t expected_elapsed_time,
+    eerratic_tick_t* elapsed_time,
+    const timer_utils_ctx_t* timer_utils,
+    const sleep_type_t sleep_type)
+{
+    if (timer_utils->get_current_time_func == NULL || timer_utils->get_event_mask_func == NULL || timer_utils->event_set == NULL)
+    {
+        return ERROR_CODE_NULL_POINTER;
+    }
+    if (timer_utils->event_set->wait_mask == 0 || (sleep_type != WAIT_ANY_EVENT && sleep_type != WAIT_ALL_EVENTS))
+    {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+
+    event_set_poll_t poll;
+    poll.timer_utils = timer_utils;
+    poll.start_time = timer_utils->get_current_time_func(timer_utils->time_ctx);
+    poll.wait_all = (sleep_type == WAIT_ALL_EVENTS);
+    timer_utils->event_set->fired_mask = 0;
+
+    timer_utils_ctx_t poll_utils = *timer_utils;
+    poll_utils.is_event_set_func = event_set_poll;
+    poll_utils.event_ctx = &poll;
+    ERROR_CODE error_code = wait_event_with_backend_ctx(loop_start_time, loop_expected_elapsed_time, poll.start_time, expected_elapsed_time, &poll_utils);
+
+    if (elapsed_time != NULL)
+    {
+        *elapsed_time = timer_utils->get_current_time_func(timer_utils->time_ctx) - poll.start_time;
+    }
+    return error_code;
+}
+
+/**
+ * @brief Sleep eerratic (context callbacks)
  * 
  * @param loop_start_time The start time of the loop
  * @param loop_expected_elapsed_time The expected elapsed time of the loop
@@ -225,10 +684,10 @@ static inline ERROR_CODE wait_time_and_event(
  * @param sleep_type The sleep type
  * @return ERROR_CODE 
  */
-static inline ERROR_CODE eerratic_sleep(
-    const uint32_t loop_start_time,
-    const uint32_t loop_expected_elapsed_time,
-    timer_utils_t* timer_utils,
+static inline ERROR_CODE eerratic_sleep_ctx(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    timer_utils_ctx_t* timer_utils,
     sleep_type_t sleep_type)
 {
     if (timer_utils->get_current_time_func == NULL)
@@ -239,37 +698,441 @@ static inline ERROR_CODE eerratic_sleep(
     switch (sleep_type)
     {
     case WAIT_EVENT:
-        return wait_timeout_or_event(
+        return wait_timeout_or_event_ctx(
             loop_start_time,
             loop_expected_elapsed_time,
             timer_utils->expected_elapsed_time,
             &timer_utils->elapsed_time,
-            timer_utils->get_current_time_func,
-            timer_utils->is_event_set_func);
+            timer_utils);
     case WAIT_TIME_AND_EVENT:
-        return wait_time_and_event(
+        return wait_time_and_event_ctx(
             loop_start_time,
             loop_expected_elapsed_time,
             timer_utils->expected_elapsed_time,
             &timer_utils->elapsed_time,
-            timer_utils->get_current_time_func,
-            timer_utils->is_event_set_func,
-            timer_utils->sleep_func);
+            timer_utils);
     case SLEEP_REMAINING_TIME:
-        sleep_remaining_time(
+        sleep_remaining_time_ctx(
+            loop_start_time,
+            loop_expected_elapsed_time,
+            timer_utils->expected_elapsed_time,
+            &timer_utils->elapsed_time,
+            timer_utils);
+        return ERROR_CODE_OK;
+    case SLEEP_REMAINING_TIME_PRECISE:
+        sleep_remaining_time_precise_ctx(
             loop_start_time,
             loop_expected_elapsed_time,
             timer_utils->expected_elapsed_time,
             &timer_utils->elapsed_time,
-            timer_utils->get_current_time_func,
-            timer_utils->sleep_func);
+            timer_utils);
         return ERROR_CODE_OK;
+    case WAIT_ANY_EVENT:
+    case WAIT_ALL_EVENTS:
+        return wait_event_set_ctx(
+            loop_start_time,
+            loop_expected_elapsed_time,
+            timer_utils->expected_elapsed_time,
+            &timer_utils->elapsed_time,
+            timer_utils,
+            sleep_type);
     default:
         return ERROR_CODE_INVALID_PARAMETER;
     }
     return ERROR_CODE_UNKNOWN;
 }
 
+
+/*
+ * Non-blocking steps. A step is started with step_poll_begin() and then
+ * polled with step_poll() until it stops returning ERROR_CODE_PENDING. The
+ * step semantics match eerratic_sleep_ctx(), but nothing ever blocks, so a
+ * single thread can drive many loops.
+ */
+typedef struct
+{
+    eerratic_tick_t start_time;
+    eerratic_tick_t expected_elapsed_time;
+    eerratic_tick_t elapsed_time;
+    sleep_type_t sleep_type;
+    bool event_seen;
+} step_poll_t;
+
+/**
+ * @brief Start a non-blocking step
+ * 
+ * @param step The step state
+ * @param expected_elapsed_time The expected elapsed time of the step
+ * @param sleep_type The sleep type
+ * @param current_time The current time
+ */
+static inline void step_poll_begin(
+    step_poll_t* step,
+    const eerratic_tick_t expected_elapsed_time,
+    const sleep_type_t sleep_type,
+    const eerratic_tick_t current_time)
+{
+    step->start_time = current_time;
+    step->expected_elapsed_time = expected_elapsed_time;
+    step->elapsed_time = 0;
+    step->sleep_type = sleep_type;
+    step->event_seen = false;
+}
+
+/**
+ * @brief Advance a non-blocking step
+ * 
+ * @param step The step state
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param current_time The current time
+ * @param timer_utils The callbacks (only is_event_set_func is used)
+ * @param wake_time Set while pending: the latest time to poll again. Steps still
+ *                  waiting for their event should also be polled when it may have fired.
+ * @return ERROR_CODE ERROR_CODE_PENDING while the step runs, then its result
+ */
+static inline ERROR_CODE step_poll(
+    step_poll_t* step,
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t current_time,
+    const timer_utils_ctx_t* timer_utils,
+    eerratic_tick_t* wake_time)
+{
+    eerratic_tick_t remaining_time;
+
+    switch (step->sleep_type)
+    {
+    case WAIT_EVENT:
+    case WAIT_TIME_AND_EVENT:
+        if (timer_utils->is_event_set_func == NULL)
+        {
+            return ERROR_CODE_NULL_POINTER;
+        }
+        if (!step->event_seen)
+        {
+            remaining_time = get_remaining_time(loop_start_time, loop_expected_elapsed_time, step->start_time, step->expected_elapsed_time, current_time);
+            if (timer_utils->is_event_set_func(timer_utils->event_ctx))
+            {
+                step->event_seen = true;
+            }
+            else if (remaining_time == 0)
+            {
+                step->elapsed_time = current_time - step->start_time;
+                return ERROR_CODE_TIMEOUT;
+            }
+            else
+            {
+                *wake_time = current_time + remaining_time;
+                return ERROR_CODE_PENDING;
+            }
+        }
+        if (step->sleep_type == WAIT_EVENT)
+        {
+            step->elapsed_time = current_time - step->start_time;
+            return ERROR_CODE_OK;
+        }
+        /* WAIT_TIME_AND_EVENT sleeps out the rest of the step once the event is seen */
+        /* fall through */
+    case SLEEP_REMAINING_TIME:
+    case SLEEP_REMAINING_TIME_PRECISE:
+        remaining_time = get_remaining_time(loop_start_time, loop_expected_elapsed_time, step->start_time, step->expected_elapsed_time, current_time);
+        if (remaining_time == 0)
+        {
+            step->elapsed_time = current_time - step->start_time;
+            return ERROR_CODE_OK;
+        }
+        *wake_time = current_time + remaining_time;
+        return ERROR_CODE_PENDING;
+    default:
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+}
+
+/*
+ * The plain function pointer API below is a thin adapter over the context
+ * API: the context of every callback points at a legacy_funcs_t holding the
+ * original function pointers.
+ */
+typedef struct
+{
+    get_current_time_func_t get_current_time_func;
+    is_event_set_func_t is_event_set_func;
+    sleep_func_t sleep_func;
+    wait_event_func_t wait_event_func;
+    get_event_mask_func_t get_event_mask_func;
+} legacy_funcs_t;
+
+static inline eerratic_tick_t legacy_get_current_time(void* ctx)
+{
+    return ((const legacy_funcs_t*)ctx)->get_current_time_func();
+}
+
+static inline bool legacy_is_event_set(void* ctx)
+{
+    return ((const legacy_funcs_t*)ctx)->is_event_set_func();
+}
+
+static inline void legacy_sleep(void* ctx, eerratic_tick_t time)
+{
+    ((const legacy_funcs_t*)ctx)->sleep_func(time);
+}
+
+static inline bool legacy_wait_event(void* ctx, eerratic_tick_t timeout)
+{
+    return ((const legacy_funcs_t*)ctx)->wait_event_func(timeout);
+}
+
+static inline uint32_t legacy_get_event_mask(void* ctx)
+{
+    return ((const legacy_funcs_t*)ctx)->get_event_mask_func();
+}
+
+/**
+ * @brief Build context callbacks that forward to plain function pointers
+ * 
+ * @param funcs The plain function pointers (must outlive the returned value)
+ * @param wait_backend The wait backend (NULL means WAIT_POLICY_SPIN)
+ * @return timer_utils_ctx_t 
+ */
+static inline timer_utils_ctx_t make_legacy_timer_utils_ctx(
+    legacy_funcs_t* funcs,
+    const wait_backend_t* wait_backend)
+{
+    timer_utils_ctx_t timer_utils;
+    timer_utils.elapsed_time = 0;
+    timer_utils.expected_elapsed_time = 0;
+    timer_utils.get_current_time_func = (funcs->get_current_time_func != NULL) ? legacy_get_current_time : NULL;
+    timer_utils.is_event_set_func = (funcs->is_event_set_func != NULL) ? legacy_is_event_set : NULL;
+    timer_utils.sleep_func = (funcs->sleep_func != NULL) ? legacy_sleep : NULL;
+    timer_utils.time_ctx = funcs;
+    timer_utils.event_ctx = funcs;
+    timer_utils.sleep_ctx = funcs;
+    timer_utils.wait_backend.policy = (wait_backend != NULL) ? wait_backend->policy : WAIT_POLICY_SPIN;
+    timer_utils.wait_backend.yield_func = (wait_backend != NULL) ? wait_backend->yield_func : NULL;
+    timer_utils.wait_backend.wait_event_func = (funcs->wait_event_func != NULL) ? legacy_wait_event : NULL;
+    timer_utils.wait_backend.wait_event_ctx = funcs;
+    timer_utils.precise_sleep = NULL;
+    timer_utils.get_event_mask_func = (funcs->get_event_mask_func != NULL) ? legacy_get_event_mask : NULL;
+    timer_utils.event_mask_ctx = funcs;
+    timer_utils.event_set = NULL;
+    return timer_utils;
+}
+
+/**
+ * @brief Sleep the remaining time
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param elapsed_time The elapsed time
+ * @param get_current_time_func The function to get the current time
+ * @param sleep_func The function to sleep
+ */
+static inline void sleep_remaining_time(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t expected_elapsed_time,
+    eerratic_tick_t* elapsed_time,
+    get_current_time_func_t get_current_time_func,
+    sleep_func_t sleep_func)
+{
+    legacy_funcs_t funcs = { get_current_time_func, NULL, sleep_func, NULL, NULL };
+    timer_utils_ctx_t timer_utils = make_legacy_timer_utils_ctx(&funcs, NULL);
+    sleep_remaining_time_ctx(loop_start_time, loop_expected_elapsed_time, expected_elapsed_time, elapsed_time, &timer_utils);
+}
+
+/**
+ * @brief Wait for the timeout or the event using a wait backend
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param elapsed_time The elapsed time
+ * @param get_current_time_func The function to get the current time
+ * @param is_event_set_func The function to check if the event is set
+ * @param sleep_func The function to sleep (optional, used to park for WAIT_POLICY_BLOCK)
+ * @param wait_backend The wait backend (NULL means WAIT_POLICY_SPIN)
+ * @return ERROR_CODE 
+ */
+static inline ERROR_CODE wait_timeout_or_event_with_backend(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t expected_elapsed_time,
+    eerratic_tick_t* elapsed_time,
+    get_current_time_func_t get_current_time_func,
+    is_event_set_func_t is_event_set_func,
+    sleep_func_t sleep_func,
+    const wait_backend_t* wait_backend)
+{
+    legacy_funcs_t funcs = { get_current_time_func, is_event_set_func, sleep_func, (wait_backend != NULL) ? wait_backend->wait_event_func : NULL, NULL };
+    timer_utils_ctx_t timer_utils = make_legacy_timer_utils_ctx(&funcs, wait_backend);
+    return wait_timeout_or_event_ctx(loop_start_time, loop_expected_elapsed_time, expected_elapsed_time, elapsed_time, &timer_utils);
+}
+
+/**
+ * @brief Wait for the timeout or the event
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param elapsed_time The elapsed time
+ * @param get_current_time_func The function to get the current time
+ * @param is_event_set_func The function to check if the event is set
+ * @return ERROR_CODE 
+ */
+static inline ERROR_CODE wait_timeout_or_event(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t expected_elapsed_time,
+    eerratic_tick_t* elapsed_time,
+    get_current_time_func_t get_current_time_func,
+    is_event_set_func_t is_event_set_func)
+{
+    return wait_timeout_or_event_with_backend(loop_start_time, loop_expected_elapsed_time, expected_elapsed_time, elapsed_time, get_current_time_func, is_event_set_func, NULL, NULL);
+}
+
+/**
+ * @brief Wait for the timeout and the event using a wait backend
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param elapsed_time The elapsed time
+ * @param get_current_time_func The function to get the current time
+ * @param is_event_set_func The function to check if the event is set
+ * @param sleep_func The function to sleep
+ * @param wait_backend The wait backend (NULL means WAIT_POLICY_SPIN)
+ * @return ERROR_CODE 
+ */
+static inline ERROR_CODE wait_time_and_event_with_backend(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t expected_elapsed_time,
+    eerratic_tick_t* elapsed_time,
+    get_current_time_func_t get_current_time_func,
+    is_event_set_func_t is_event_set_func,
+    sleep_func_t sleep_func,
+    const wait_backend_t* wait_backend)
+{
+    legacy_funcs_t funcs = { get_current_time_func, is_event_set_func, sleep_func, (wait_backend != NULL) ? wait_backend->wait_event_func : NULL, NULL };
+    timer_utils_ctx_t timer_utils = make_legacy_timer_utils_ctx(&funcs, wait_backend);
+    return wait_time_and_event_ctx(loop_start_time, loop_expected_elapsed_time, expected_elapsed_time, elapsed_time, &timer_utils);
+}
+
+/**
+ * @brief Wait for the timeout and the event
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param elapsed_time The elapsed time
+ * @param get_current_time_func The function to get the current time
+ * @param is_event_set_func The function to check if the event is set
+ * @param sleep_func The function to sleep
+ * @return ERROR_CODE 
+ */
+static inline ERROR_CODE wait_time_and_event(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t expected_elapsed_time,
+    eerratic_tick_t* elapsed_time,
+    get_current_time_func_t get_current_time_func,
+    is_event_set_func_t is_event_set_func,
+    sleep_func_t sleep_func)
+{
+    return wait_time_and_event_with_backend(loop_start_time, loop_expected_elapsed_time, expected_elapsed_time, elapsed_time, get_current_time_func, is_event_set_func, sleep_func, NULL);
+}
+
+/**
+ * @brief Wait until any or all events of the event set fired, or the timeout
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param expected_elapsed_time The expected elapsed time of the timer
+ * @param elapsed_time The elapsed time
+ * @param get_current_time_func The function to get the current time
+ * @param get_event_mask_func The function returning every event currently set as a bit mask
+ * @param sleep_func The function to sleep (optional, used to park for WAIT_POLICY_BLOCK)
+ * @param event_set The events to wait for, filled with the fired events
+ * @param sleep_type WAIT_ANY_EVENT or WAIT_ALL_EVENTS
+ * @param wait_backend The wait backend (NULL means WAIT_POLICY_SPIN)
+ * @return ERROR_CODE 
+ */
+static inline ERROR_CODE wait_event_set(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    const eerratic_tick_t expected_elapsed_time,
+    eerratic_tick_t* elapsed_time,
+    get_current_time_func_t get_current_time_func,
+    get_event_mask_func_t get_event_mask_func,
+    sleep_func_t sleep_func,
+    event_set_t* event_set,
+    const sleep_type_t sleep_type,
+    const wait_backend_t* wait_backend)
+{
+    legacy_funcs_t funcs = { get_current_time_func, NULL, sleep_func, (wait_backend != NULL) ? wait_backend->wait_event_func : NULL, get_event_mask_func };
+    timer_utils_ctx_t timer_utils = make_legacy_timer_utils_ctx(&funcs, wait_backend);
+    timer_utils.event_set = event_set;
+    return wait_event_set_ctx(loop_start_time, loop_expected_elapsed_time, expected_elapsed_time, elapsed_time, &timer_utils, sleep_type);
+}
+
+/**
+ * @brief Sleep eerratic using a wait backend
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param timer_utils The timer utils
+ * @param sleep_type The sleep type
+ * @param wait_backend The wait backend (NULL means WAIT_POLICY_SPIN)
+ * @return ERROR_CODE 
+ */
+static inline ERROR_CODE eerratic_sleep_with_backend(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    timer_utils_t* timer_utils,
+    sleep_type_t sleep_type,
+    const wait_backend_t* wait_backend)
+{
+    if (timer_utils->get_current_time_func == NULL)
+    {
+        return ERROR_CODE_NULL_POINTER;
+    }
+
+    legacy_funcs_t funcs = {
+        timer_utils->get_current_time_func,
+        timer_utils->is_event_set_func,
+        timer_utils->sleep_func,
+        (wait_backend != NULL) ? wait_backend->wait_event_func : NULL,
+        NULL
+    };
+    timer_utils_ctx_t timer_utils_ctx = make_legacy_timer_utils_ctx(&funcs, wait_backend);
+    timer_utils_ctx.elapsed_time = timer_utils->elapsed_time;
+    timer_utils_ctx.expected_elapsed_time = timer_utils->expected_elapsed_time;
+
+    ERROR_CODE error_code = eerratic_sleep_ctx(loop_start_time, loop_expected_elapsed_time, &timer_utils_ctx, sleep_type);
+    timer_utils->elapsed_time = timer_utils_ctx.elapsed_time;
+    return error_code;
+}
+
+/**
+ * @brief Sleep eerratic
+ * 
+ * @param loop_start_time The start time of the loop
+ * @param loop_expected_elapsed_time The expected elapsed time of the loop
+ * @param timer_utils The timer utils
+ * @param sleep_type The sleep type
+ * @return ERROR_CODE 
+ */
+static inline ERROR_CODE eerratic_sleep(
+    const eerratic_tick_t loop_start_time,
+    const eerratic_tick_t loop_expected_elapsed_time,
+    timer_utils_t* timer_utils,
+    sleep_type_t sleep_type)
+{
+    return eerratic_sleep_with_backend(loop_start_time, loop_expected_elapsed_time, timer_utils, sleep_type, NULL);
+}
+
 #ifdef __cplusplus
 }
 #endif
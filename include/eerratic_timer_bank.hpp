@@ -0,0 +1,182 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_TIMER_BANK_HPP
+#define EERRATIC_TIMER_BANK_HPP
+
+#include "eerratic_timer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+
+/**
+ * @brief Deadlines of many channels, checked together
+ *
+ * Each channel holds the four arguments of is_timer_expired() (loop start,
+ * loop budget, step start, step budget) in structure-of-arrays form, and
+ * scan() evaluates check_timer_expired() for every channel against one
+ * clock read. The scan works on blocks of 64 channels with branch-free
+ * compares over contiguous arrays, which the compiler turns into SIMD code,
+ * and packs the results into one bit per channel: a channel is either in the
+ * TOTAL_TIMEOUT mask, in the TIMEOUT mask, or in neither (ERROR_CODE_OK).
+ * Disabled channels are in neither.
+ */
+class EEerraticTimerBank {
+public:
+    static constexpr size_t kBlockSize = 64;
+
+    explicit EEerraticTimerBank(size_t channelCount)
+        : m_channelCount(channelCount),
+          m_loopStartTimes(paddedSize(channelCount), 0),
+          m_loopExpectedElapsedTimes(paddedSize(channelCount), 0),
+          m_startTimes(paddedSize(channelCount), 0),
+          m_expectedElapsedTimes(paddedSize(channelCount), 0),
+          m_enabledMask(paddedSize(channelCount) / kBlockSize, 0),
+          m_timeoutMask(paddedSize(channelCount) / kBlockSize, 0),
+          m_totalTimeoutMask(paddedSize(channelCount) / kBlockSize, 0)
+    {
+    }
+
+    size_t size() const { return m_channelCount; }
+    size_t wordCount() const { return m_enabledMask.size(); }
+
+    // Arms a channel; same argument order as is_timer_expired()
+    void setChannel(size_t channel,
+                    eerratic_tick_t loopStartTime,
+                    eerratic_tick_t loopExpectedElapsedTime,
+                    eerratic_tick_t startTime,
+                    eerratic_tick_t expectedElapsedTime) {
+        checkChannel(channel);
+        m_loopStartTimes[channel] = loopStartTime;
+        m_loopExpectedElapsedTimes[channel] = loopExpectedElapsedTime;
+        m_startTimes[channel] = startTime;
+        m_expectedElapsedTimes[channel] = expectedElapsedTime;
+        m_enabledMask[channel / kBlockSize] |= bit(channel);
+    }
+
+    // Starts the next step of an armed channel, keeping its loop
+    void startStep(size_t channel, eerratic_tick_t startTime, eerratic_tick_t expectedElapsedTime) {
+        checkChannel(channel);
+        m_startTimes[channel] = startTime;
+        m_expectedElapsedTimes[channel] = expectedElapsedTime;
+    }
+
+    void disableChannel(size_t channel) {
+        checkChannel(channel);
+        m_enabledMask[channel / kBlockSize] &= ~bit(channel);
+    }
+
+    /**
+     * @brief Check every enabled channel against the current time
+     *
+     * @param currentTime One clock read shared by all channels
+     * @return size_t Number of channels that are not ERROR_CODE_OK
+     */
+    size_t scan(eerratic_tick_t currentTime) {
+        size_t expiredCount = 0;
+        for (size_t word = 0; word < m_enabledMask.size(); word++) {
+            const size_t base = word * kBlockSize;
+            const uint64_t total = expiredBits(&m_loopStartTimes[base], &m_loopExpectedElapsedTimes[base], currentTime);
+            const uint64_t step = expiredBits(&m_startTimes[base], &m_expectedElapsedTimes[base], currentTime);
+            const uint64_t enabled = m_enabledMask[word];
+            m_totalTimeoutMask[word] = total & enabled;
+            m_timeoutMask[word] = step & ~total & enabled;
+            expiredCount += popcount(m_totalTimeoutMask[word] | m_timeoutMask[word]);
+        }
+        return expiredCount;
+    }
+
+    // Results of the last scan(), bit (channel % 64) of word (channel / 64)
+    const std::vector<uint64_t>& getTimeoutMask() const { return m_timeoutMask; }
+    const std::vector<uint64_t>& getTotalTimeoutMask() const { return m_totalTimeoutMask; }
+
+    ERROR_CODE getResult(size_t channel) const {
+        checkChannel(channel);
+        if (m_totalTimeoutMask[channel / kBlockSize] & bit(channel)) {
+            return ERROR_CODE_TOTAL_TIMEOUT;
+        }
+        if (m_timeoutMask[channel / kBlockSize] & bit(channel)) {
+            return ERROR_CODE_TIMEOUT;
+        }
+        return ERROR_CODE_OK;
+    }
+
+    // Calls func(channel, ERROR_CODE) for each expired channel of the last scan(), in channel order
+    template <typename F>
+    void forEachExpired(F&& func) const {
+        for (size_t word = 0; word < m_timeoutMask.size(); word++) {
+            uint64_t bits = m_timeoutMask[word] | m_totalTimeoutMask[word];
+            while (bits) {
+                const uint64_t lowest = bits & (~bits + 1);
+                const size_t channel = word * kBlockSize + popcount(lowest - 1);
+                func(channel, (m_totalTimeoutMask[word] & lowest) ? ERROR_CODE_TOTAL_TIMEOUT : ERROR_CODE_TIMEOUT);
+                bits &= bits - 1;
+            }
+        }
+    }
+
+private:
+    static size_t paddedSize(size_t channelCount) {
+        return (channelCount + kBlockSize - 1) / kBlockSize * kBlockSize;
+    }
+
+    static uint64_t bit(size_t channel) {
+        return uint64_t(1) << (channel % kBlockSize);
+    }
+
+    void checkChannel(size_t channel) const {
+        if (channel >= m_channelCount) {
+            throw std::out_of_range("invalid timer bank channel");
+        }
+    }
+
+    static size_t popcount(uint64_t bits) {
+#if defined(__GNUC__)
+        return static_cast<size_t>(__builtin_popcountll(bits));
+#else
+        size_t count = 0;
+        for (; bits; bits &= bits - 1) {
+            count++;
+        }
+        return count;
+#endif
+    }
+
+    // Same wrap-safe compare as check_timer_expired(), for one block. The
+    // compare loop writes 0/1 bytes; each multiply then gathers eight of
+    // them into the top byte (byte i of the product lands on bit i).
+    static uint64_t expiredBits(const eerratic_tick_t* starts, const eerratic_tick_t* budgets, eerratic_tick_t currentTime) {
+        uint8_t flags[kBlockSize];
+        for (size_t i = 0; i < kBlockSize; i++) {
+            flags[i] = static_cast<uint8_t>(currentTime - starts[i] >= budgets[i]);
+        }
+        uint64_t bits = 0;
+        for (size_t i = 0; i < kBlockSize; i += 8) {
+            uint64_t eight;
+            std::memcpy(&eight, &flags[i], sizeof(eight));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            eight = __builtin_bswap64(eight);
+#endif
+            bits |= ((eight * 0x0102040810204080ull) >> 56) << i;
+        }
+        return bits;
+    }
+
+    size_t m_channelCount;
+    std::vector<eerratic_tick_t> m_loopStartTimes;
+    std::vector<eerratic_tick_t> m_loopExpectedElapsedTimes;
+    std::vector<eerratic_tick_t> m_startTimes;
+    std::vector<eerratic_tick_t> m_expectedElapsedTimes;
+    std::vector<uint64_t> m_enabledMask;
+    std::vector<uint64_t> m_timeoutMask;
+    std::vector<uint64_t> m_totalTimeoutMask;
+};
+
+#endif // EERRATIC_TIMER_BANK_HPP
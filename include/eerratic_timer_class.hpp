@@ -7,34 +7,369 @@
 #ifndef EERRATIC_TIMER_CLASS_HPP
 #define EERRATIC_TIMER_CLASS_HPP
 
+#include "eerratic_callback.hpp"
+#include "eerratic_event.hpp"
+#include "eerratic_histogram.hpp"
+#include "eerratic_metrics.hpp"
 #include "eerratic_timer.h"
+#include "eerratic_trace.hpp"
+#include "eerratic_watchdog.hpp"
 
 #include <algorithm>
+#include <initializer_list>
+#include <memory>
 #include <stdexcept>
-#include <unordered_map>
+#include <string>
 #include <vector>
 
 
 class EEerraticTimer {
 public:
+    // Plain function pointers and small callables (lambdas with captures,
+    // functors) are both accepted and stored inline without allocation.
+    using TimeFunction = EEerraticCallback<eerratic_tick_t()>;
+    using SleepFunction = EEerraticCallback<void(eerratic_tick_t)>;
+    using EventFunction = EEerraticCallback<bool()>;
+    using WaitEventFunction = EEerraticCallback<bool(eerratic_tick_t)>;
+    using EventMaskFunction = EEerraticCallback<uint32_t()>;
+    // Reports when the step's event fired (false if unknown), in the timer's clock
+    using EventTimeFunction = EEerraticCallback<bool(eerratic_tick_t&)>;
+
     struct StepConfig {
-        uint32_t expectedElapsedTime;
-        is_event_set_func_t isEventSetFunc;
+        eerratic_tick_t expectedElapsedTime;
+        EventFunction isEventSetFunc;
         sleep_type_t sleepType;
+        wait_policy_t waitPolicy;
+        WaitEventFunction waitEventFunc;
+        EventMaskFunction getEventMaskFunc;
+        EventTimeFunction getEventTimeFunc;
+        uint8_t criticality;        // 0: mandatory, higher levels are shed first
+    };
+
+    /**
+     * @brief Compact handle of a step, indexing the dense step table directly
+     */
+    struct StepHandle {
+        uint32_t index;
+    };
+
+    struct StepStats {
+        uint64_t count;
+        uint64_t overrunCount;
+        eerratic_tick_t min;
+        eerratic_tick_t max;
+        double mean;
+        eerratic_tick_t p50;
+        eerratic_tick_t p90;
+        eerratic_tick_t p99;
+        eerratic_tick_t p999;
+        double meanJitter;
+        eerratic_tick_t maxJitter;
+        uint64_t borrowedTime;      // Slack used beyond the step budget (slack mode)
+        uint64_t donatedTime;       // Budget left unused and banked for later steps (slack mode)
+        uint64_t eventLatencyCount; // Event-to-wake latencies recorded (event time source set)
+        eerratic_tick_t eventLatencyP50;
+        eerratic_tick_t eventLatencyP99;
+        eerratic_tick_t eventLatencyMax;
+        uint64_t shedCount;         // Runs skipped to keep more critical steps on time
+        uint64_t shortenedCount;    // Runs given less than their budget for the same reason
+    };
+
+    // When the event of the last WAIT_EVENT / WAIT_TIME_AND_EVENT run fired and was seen
+    struct EventTiming {
+        bool valid;
+        eerratic_tick_t firedTime;
+        eerratic_tick_t detectedTime;
+    };
+
+    // Budget tuning of event-wait steps (WAIT_EVENT, WAIT_ANY_EVENT, WAIT_ALL_EVENTS), learned
+    // from the runs since the step's budget last changed (or resetStats()).
+    struct AutoTuneConfig {
+        double percentile;          // Of the observed step times, in [0, 100]
+        eerratic_tick_t margin;     // Added to the percentile
+        uint64_t minSamples;        // Runs needed before a budget is proposed
     };
 
-    EEerraticTimer(uint32_t, get_current_time_func_t, sleep_func_t);
-    void addStep(int, uint32_t, is_event_set_func_t, sleep_type_t);
+    struct BudgetProposal {
+        int id;
+        eerratic_tick_t current;
+        eerratic_tick_t proposed;
+        uint64_t samples;
+        bool censored;              // Too many timeouts to see the percentile: at least doubles the budget
+        bool capped;                // Limited to the loop budget
+    };
+
+    // Whether the steps fit the loop budget. Every step counts once per loop, a parallel
+    // group as its slowest member. Headrooms are negative when the loop budget is exceeded.
+    struct FeasibilityReport {
+        eerratic_tick_t period;
+        // The paths leave out a trailing loop-remainder step, which only fills the period
+        eerratic_tick_t budgetPath;         // Sum of the step budgets
+        eerratic_tick_t meanPath;           // Sum of the mean step times
+        eerratic_tick_t worstPath;          // Sum of the maximum step times
+        std::vector<int> criticalPath;      // Steps making up worstPath
+        // Loops measured from one resetLoop() / nextPeriod() to the next, minus the loop-remainder step
+        uint64_t loopCount;
+        eerratic_tick_t loopP99;
+        eerratic_tick_t loopMax;
+        int64_t budgetHeadroom;             // period - budgetPath
+        int64_t worstHeadroom;              // period - worstPath
+        int64_t loopHeadroom;               // period - loopP99, includes the work between steps
+
+        bool fits() const;
+        std::string describe() const;
+    };
+
+    // What nextPeriod() does when one or more whole periods were missed
+    enum class OverrunPolicy {
+        Skip,           // Drop the missed periods and start at the current period boundary
+        CatchUp,        // Start the missed periods immediately, one after another
+        PhaseReset      // Start now and restart the period grid from here
+    };
+
+    EEerraticTimer(eerratic_tick_t, TimeFunction, SleepFunction);
+    ~EEerraticTimer();
+    EEerraticTimer(EEerraticTimer&&) noexcept;
+    EEerraticTimer& operator=(EEerraticTimer&&) noexcept;
+    StepHandle addStep(int, eerratic_tick_t, EventFunction, sleep_type_t,
+                       wait_policy_t = WAIT_POLICY_SPIN, WaitEventFunction = nullptr);
+    // WAIT_EVENT / WAIT_TIME_AND_EVENT step blocking on the event (WAIT_POLICY_BLOCK); the event must outlive the timer
+    StepHandle addStep(int, eerratic_tick_t, EEerraticEvent&, sleep_type_t);
+    // WAIT_ANY_EVENT / WAIT_ALL_EVENTS step over the events of waitMask, all read by one EventMaskFunction call
+    StepHandle addStep(int, eerratic_tick_t, EventMaskFunction, uint32_t, sleep_type_t,
+                       wait_policy_t = WAIT_POLICY_SPIN, WaitEventFunction = nullptr);
     void resetLoop();
+    // Periodic mode: loop N starts at t0 + N * period, t0 being set by startPeriodic().
+    // nextPeriod() ends the current loop, waits for the next boundary if it is still
+    // ahead and returns ERROR_CODE_TOTAL_TIMEOUT if whole periods were missed.
+    void startPeriodic(OverrunPolicy = OverrunPolicy::Skip);
+    ERROR_CODE nextPeriod();
+    uint64_t getMissedPeriodCount() const;
+    uint64_t getLatePeriodCount() const;
+    // Slack mode: time a step leaves unused is banked for the rest of the loop, and
+    // later event-wait steps may run over their budget by up to maxBorrow of it.
+    // The bank empties at every loop start; the loop budget is still enforced.
+    void enableSlack(eerratic_tick_t maxBorrow);
+    void disableSlack();
+    eerratic_tick_t getSlack() const;
+    // Handle of an added step; unknown ids give a handle every call rejects
+    StepHandle getStepHandle(int id) const { return StepHandle{ findStep(id) }; }
     ERROR_CODE executeSleep(int);
-    uint32_t getLastElapsedTime() const;
-    uint32_t getLoopStartTime() const;
+    ERROR_CODE executeSleep(StepHandle);
+    // Non-blocking step (step_poll): beginStep() starts it, then pollStep() is called
+    // until it stops returning ERROR_CODE_PENDING, each time with the current time.
+    // While pending, wakeTime is the latest time to poll again; a step for which
+    // isPollingEvent() is true should also be polled when its event may have fired.
+    // One step at a time; WAIT_ANY_EVENT / WAIT_ALL_EVENTS are not supported.
+    ERROR_CODE beginStep(StepHandle);
+    ERROR_CODE pollStep(eerratic_tick_t currentTime, eerratic_tick_t& wakeTime);
+    bool isPollingEvent() const;
+    // Parallel group: executeGroup() runs the member steps concurrently on worker
+    // threads and returns once every member completed or hit its deadline. The
+    // result is the worst member result; getLastElapsedTime() is the group's.
+    // The time, sleep and event functions must then be callable from any thread.
+    void addGroup(int, std::initializer_list<int>);
+    ERROR_CODE executeGroup(int);
+    // Elapsed time of each member in the last executeGroup(), in addGroup() order
+    const std::vector<eerratic_tick_t>* getGroupElapsedTimes(int) const;
+    eerratic_tick_t getLastElapsedTime() const;
+    eerratic_tick_t getLoopStartTime() const;
+    ERROR_CODE getStepStats(int, StepStats&) const;
+    const EEerraticHistogram* getStepHistogram(int) const;
+    // Event-to-wake latency: the step records when its event was first seen set, and
+    // the source tells when it fired. Steps added with an EEerraticEvent use its set(time).
+    ERROR_CODE setEventTimeFunc(int, EventTimeFunction);
+    // Load shedding: a step with criticality > 0 is optional. When it starts, the time
+    // left in the loop is first reserved for the steps added after it with a lower level,
+    // mandatory (0) ones included. The step then runs on what is left, shortened if that
+    // is less than its budget, or is skipped with ERROR_CODE_SHED if nothing is left.
+    // Group members are never shed.
+    ERROR_CODE setStepCriticality(int, uint8_t);
+    ERROR_CODE getLastEventTiming(int, EventTiming&) const;
+    const EEerraticHistogram* getEventLatencyHistogram(int) const;
+    // Learned margin and achieved deadline error of a SLEEP_REMAINING_TIME_PRECISE step
+    ERROR_CODE getPreciseSleepState(int, precise_sleep_t&) const;
+    // Events that fired in the last run of a WAIT_ANY_EVENT / WAIT_ALL_EVENTS step, and when
+    ERROR_CODE getEventSet(int, event_set_t&) const;
+    void resetStats();
+    std::vector<BudgetProposal> proposeBudgets(const AutoTuneConfig&) const;
+    // Applies every proposal and returns how many budgets changed
+    size_t applyBudgets(const AutoTuneConfig&);
+    // Auto-tune mode: a step's proposal is applied after every minSamples runs of it
+    void enableAutoTune(const AutoTuneConfig&);
+    void disableAutoTune();
+    FeasibilityReport getFeasibilityReport() const;
+    const EEerraticHistogram& getLoopHistogram() const;
+    // Record every executed step into the buffer (nullptr disables tracing).
+    // The caller keeps ownership; the timer thread is the buffer's producer.
+    void setTraceBuffer(EEerraticTraceBuffer*, uint32_t loopId = 0);
+    // Publish step and loop metrics into the exporter's shared file (nullptr disables it).
+    // Step slots follow addStep() order; a loop ends at the next resetLoop() or nextPeriod().
+    void setMetricsExporter(EEerraticMetricsExporter*);
+    // Publish the running step's and the loop's deadlines to a channel of the watchdog
+    // (nullptr detaches). The watchdog must outlive the timer.
+    void setWatchdog(EEerraticWatchdog*, uint32_t channelId = 0);
 
 private:
-    timer_utils_t m_timerUtils{};
-    std::unordered_map<int, StepConfig> m_steps;
-    uint32_t m_loopExpectedElapsedTime = 0;
-    uint32_t m_loopStartTime = 0;
+    struct StepRecorder {
+        EEerraticHistogram histogram;
+        uint64_t overrunCount = 0;
+        uint64_t elapsedSum = 0;
+        uint64_t jitterSum = 0;
+        eerratic_tick_t maxJitter = 0;
+        eerratic_tick_t lastElapsed = 0;
+        uint64_t borrowedSum = 0;
+        uint64_t donatedSum = 0;
+        EEerraticHistogram eventLatency;
+        EventTiming lastEventTiming{};
+        // Runs under the current budget, for the budget tuning
+        EEerraticHistogram tuning;
+        uint64_t tuningTimeouts = 0;
+        uint64_t shedCount = 0;
+        uint64_t shortenedCount = 0;
+
+        void record(eerratic_tick_t elapsed, ERROR_CODE result) {
+            if (histogram.getTotalCount() > 0) {
+                eerratic_tick_t jitter = elapsed > lastElapsed ? elapsed - lastElapsed : lastElapsed - elapsed;
+                jitterSum += jitter;
+                maxJitter = jitter > maxJitter ? jitter : maxJitter;
+            }
+            histogram.record(elapsed);
+            tuning.record(elapsed);
+            elapsedSum += elapsed;
+            lastElapsed = elapsed;
+            if (result == ERROR_CODE_TIMEOUT || result == ERROR_CODE_TOTAL_TIMEOUT) {
+                overrunCount++;
+                tuningTimeouts++;
+            }
+        }
+
+        void reset() {
+            *this = StepRecorder{};
+        }
+    };
+
+    struct Group {
+        int id;
+        std::vector<uint32_t> slots;
+        std::vector<ERROR_CODE> results;
+        std::vector<eerratic_tick_t> beginTimes;
+        std::vector<eerratic_tick_t> endTimes;
+        std::vector<eerratic_tick_t> elapsedTimes;
+    };
+
+    struct GroupWorkers;
+
+    // Owns the attachment to a watchdog channel: a moved-from or destroyed timer
+    // leaves no deadline armed on it
+    // Owns the timer's channel: releasing it removes the channel from the watchdog
+    struct WatchdogLink {
+        EEerraticWatchdog* watchdog = nullptr;
+        EEerraticWatchdog::Channel* channel = nullptr;
+
+        WatchdogLink() = default;
+        WatchdogLink(EEerraticWatchdog* owner, uint32_t channelId)
+            : watchdog(owner), channel(owner ? &owner->addChannel(channelId) : nullptr) {}
+        WatchdogLink(WatchdogLink&& other) noexcept : watchdog(other.watchdog), channel(other.channel) {
+            other.watchdog = nullptr;
+            other.channel = nullptr;
+        }
+        WatchdogLink& operator=(WatchdogLink&& other) noexcept {
+            if (this != &other) {
+                release();
+                watchdog = other.watchdog;
+                channel = other.channel;
+                other.watchdog = nullptr;
+                other.channel = nullptr;
+            }
+            return *this;
+        }
+        ~WatchdogLink() { release(); }
+
+        void release() {
+            if (channel) {
+                watchdog->removeChannel(*channel);
+                watchdog = nullptr;
+                channel = nullptr;
+            }
+        }
+    };
+
+    // Wraps is_event_set_func to note when the event is first seen set
+    struct EventDetector {
+        is_event_set_ctx_func_t isEventSetFunc;
+        void* eventCtx;
+        const TimeFunction* getCurrentTimeFunc;
+        bool detected;
+        eerratic_tick_t detectedTime;
+
+        static bool isEventSet(void*);
+    };
+
+    static constexpr uint32_t kNoStep = UINT32_MAX;
+
+    struct StepIndexEntry {
+        int id;
+        uint32_t slot;
+    };
+
+    static bool isBefore(const StepIndexEntry& entry, int id) { return entry.id < id; }
+
+    uint32_t findStep(int id) const {
+        auto it = std::lower_bound(m_stepIndex.begin(), m_stepIndex.end(), id, isBefore);
+        return (it != m_stepIndex.end() && it->id == id) ? it->slot : kNoStep;
+    }
+
+    void bindStep(uint32_t, timer_utils_ctx_t&);
+    void runGroupMember(Group&, size_t);
+    Group* findGroup(int);
+    eerratic_tick_t grantSlack(const StepConfig&) const;
+    bool isLoopRemainder(uint32_t) const;
+    void settleSlack(const StepConfig&, StepRecorder&, eerratic_tick_t elapsed);
+    void finishStep(uint32_t, ERROR_CODE, eerratic_tick_t beginTime, const EventDetector*);
+    void autoTune(uint32_t);
+    bool shedStep(uint32_t, eerratic_tick_t now, eerratic_tick_t& budget);
+    bool proposeBudget(uint32_t, const AutoTuneConfig&, BudgetProposal&) const;
+    void setBudget(uint32_t, eerratic_tick_t);
+    void endLoop(eerratic_tick_t now);
+    void beginLoop();
+
+    TimeFunction m_getCurrentTimeFunc;
+    SleepFunction m_sleepFunc;
+    timer_utils_ctx_t m_timerUtils{};
+    // Step ids map to dense slots through an id-sorted index; configs and statistics
+    // live in parallel arrays. Hot paths take a StepHandle and skip the lookup.
+    std::vector<StepIndexEntry> m_stepIndex;
+    std::vector<StepConfig> m_stepConfigs;
+    std::vector<StepRecorder> m_stepStats;
+    std::vector<int> m_stepIds;
+    std::vector<precise_sleep_t> m_preciseSleeps;
+    std::vector<event_set_t> m_eventSets;
+    eerratic_tick_t m_loopExpectedElapsedTime = 0;
+    eerratic_tick_t m_loopStartTime = 0;
+    OverrunPolicy m_overrunPolicy = OverrunPolicy::Skip;
+    uint64_t m_missedPeriodCount = 0;
+    uint64_t m_latePeriodCount = 0;
+    bool m_slackEnabled = false;
+    eerratic_tick_t m_maxBorrow = 0;
+    eerratic_tick_t m_slack = 0;
+    std::vector<Group> m_groups;
+    std::unique_ptr<GroupWorkers> m_groupWorkers;  // Created by the first executeGroup()
+    EEerraticTraceBuffer* m_traceBuffer = nullptr;
+    uint32_t m_traceLoopId = 0;
+    EEerraticMetricsExporter* m_metricsExporter = nullptr;
+    bool m_loopActive = false;
+    WatchdogLink m_watchdog;
+    EEerraticHistogram m_loopHistogram;
+    eerratic_tick_t m_loopRemainderTime = 0;       // Spent in the loop-remainder step this loop
+    bool m_autoTuneEnabled = false;
+    AutoTuneConfig m_autoTune{};
+    // State of the step driven by beginStep() / pollStep()
+    step_poll_t m_poll{};
+    uint32_t m_pollSlot = kNoStep;
+    eerratic_tick_t m_pollBeginTime = 0;
+    bool m_pollDetectEvent = false;
+    EventDetector m_pollDetector{};
 };
 
 #endif // EERRATIC_TIMER_CLASS_HPP
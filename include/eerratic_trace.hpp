@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_TRACE_HPP
+#define EERRATIC_TRACE_HPP
+
+#include "eerratic_timer.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <stdexcept>
+#include <thread>
+
+
+struct EEerraticTraceRecord {
+    eerratic_tick_t beginTime;
+    eerratic_tick_t endTime;
+    int32_t stepId;
+    int32_t result;     // ERROR_CODE of the step
+    uint32_t loopId;
+};
+
+/**
+ * @brief Lock-free single-producer / single-consumer ring of trace records
+ *
+ * Memory is allocated once at construction. push() never blocks or
+ * allocates; when the ring is full the record is dropped and counted.
+ * Exactly one thread may push and exactly one (other) thread may drain.
+ */
+class EEerraticTraceBuffer {
+public:
+    explicit EEerraticTraceBuffer(size_t capacity)
+        : m_mask(roundUpPowerOfTwo(capacity) - 1),
+          m_records(new EEerraticTraceRecord[m_mask + 1])
+    {
+        if (capacity == 0) {
+            throw std::invalid_argument("trace buffer capacity must be positive");
+        }
+    }
+
+    bool push(const EEerraticTraceRecord& record) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head - m_tail.load(std::memory_order_acquire) > m_mask) {
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        m_records[head & m_mask] = record;
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Move up to maxCount records into out, oldest first
+     *
+     * @return size_t Number of records copied
+     */
+    size_t drain(EEerraticTraceRecord* out, size_t maxCount) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t head = m_head.load(std::memory_order_acquire);
+        size_t count = head - tail;
+        count = count < maxCount ? count : maxCount;
+        for (size_t i = 0; i < count; i++) {
+            out[i] = m_records[(tail + i) & m_mask];
+        }
+        m_tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    size_t capacity() const { return m_mask + 1; }
+    uint64_t getDroppedCount() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    static size_t roundUpPowerOfTwo(size_t value) {
+        size_t result = 1;
+        while (result < value) {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    const size_t m_mask;
+    std::unique_ptr<EEerraticTraceRecord[]> m_records;
+    alignas(64) std::atomic<size_t> m_head{0};
+    alignas(64) std::atomic<size_t> m_tail{0};
+    alignas(64) std::atomic<uint64_t> m_dropped{0};
+};
+
+/**
+ * @brief Write records as Chrome trace events (one complete "X" event per step)
+ *
+ * The output of writeChromeTraceBegin(), any number of writeChromeTraceRecords()
+ * calls and writeChromeTraceEnd() is a JSON document that chrome://tracing and
+ * Perfetto open directly. Each loop id becomes its own track.
+ */
+void writeChromeTraceBegin(std::ostream&);
+void writeChromeTraceRecords(std::ostream&, const EEerraticTraceRecord*, size_t, bool& first);
+void writeChromeTraceEnd(std::ostream&);
+
+/**
+ * @brief Drain a trace buffer completely into a Chrome trace JSON document
+ *
+ * @return size_t Number of records written
+ */
+size_t exportChromeTrace(EEerraticTraceBuffer&, std::ostream&);
+
+/**
+ * @brief Background thread that drains a trace buffer into a Chrome trace stream
+ */
+class EEerraticTraceWriter {
+public:
+    EEerraticTraceWriter(EEerraticTraceBuffer&, std::ostream&, uint32_t drainIntervalMs = 10);
+    ~EEerraticTraceWriter();
+
+    EEerraticTraceWriter(const EEerraticTraceWriter&) = delete;
+    EEerraticTraceWriter& operator=(const EEerraticTraceWriter&) = delete;
+
+    void start();
+    void stop();
+    uint64_t getWrittenCount() const;
+
+private:
+    void drainOnce();
+
+    EEerraticTraceBuffer& m_buffer;
+    std::ostream& m_stream;
+    uint32_t m_drainIntervalMs;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<uint64_t> m_written{0};
+    bool m_first = true;
+};
+
+#endif // EERRATIC_TRACE_HPP
@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_TSC_CLOCK_HPP
+#define EERRATIC_TSC_CLOCK_HPP
+
+#include "eerratic_clock.h"
+
+#include <cstdint>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define EERRATIC_HAS_TSC 1
+#endif
+
+
+/**
+ * @brief Clock reading the CPU time stamp counter, calibrated against CLOCK_MONOTONIC
+ *
+ * A TSC read costs a few ns, cheaper than clock_gettime(), which matters when
+ * spinning waits poll the clock in a tight loop. The counter is converted to
+ * nanoseconds with a fixed-point factor measured over calibrationTime at
+ * construction. Without an invariant TSC (not x86, or a counter that stops or
+ * changes rate with the core frequency) it falls back to
+ * eerratic_monotonic_time(); isTscEnabled() tells which one is used.
+ *
+ * Readings share the CLOCK_MONOTONIC origin, so the two providers can be
+ * mixed. Calibration error accumulates as drift (typically a few ppm);
+ * call calibrate() again in long-running processes if that matters.
+ *
+ * With EEerraticTimer, wrap now() in a lambda; nowCtx plugs into timer_utils_ctx_t.
+ */
+class EEerraticTscClock {
+public:
+    explicit EEerraticTscClock(eerratic_tick_t calibrationTime = 10 * EERRATIC_TICKS_PER_MS) {
+#ifdef EERRATIC_HAS_TSC
+        m_tscEnabled = hasInvariantTsc();
+#endif
+        calibrate(calibrationTime);
+    }
+
+    void calibrate(eerratic_tick_t calibrationTime) {
+#ifdef EERRATIC_HAS_TSC
+        if (!m_tscEnabled) {
+            return;
+        }
+        // Measured in nanoseconds so that coarse time bases still calibrate precisely
+        const uint64_t calibrationNs = static_cast<uint64_t>(calibrationTime) * kNsPerTick;
+        const uint64_t startCycles = __rdtsc();
+        const uint64_t startNs = eerratic_monotonic_ns();
+        uint64_t endNs = startNs;
+        while (endNs - startNs < calibrationNs) {
+            endNs = eerratic_monotonic_ns();
+        }
+        const uint64_t endCycles = __rdtsc();
+        const uint64_t cycles = endCycles - startCycles;
+        if (cycles == 0) {
+            m_tscEnabled = false;
+            return;
+        }
+        m_nsPerCycle = fixedPointRatio(endNs - startNs, cycles);
+        m_baseCycles = endCycles;
+        m_baseNs = endNs;
+#else
+        (void)calibrationTime;
+#endif
+    }
+
+    eerratic_tick_t now() const {
+#ifdef EERRATIC_HAS_TSC
+        if (m_tscEnabled) {
+            // A read just below the calibration base (another core, or rdtsc reordered
+            // around calibrate()) must not wrap to a huge unsigned difference
+            const int64_t delta = static_cast<int64_t>(__rdtsc() - m_baseCycles);
+            const uint64_t cycles = (delta > 0) ? static_cast<uint64_t>(delta) : 0;
+            const uint64_t ns = m_baseNs + fixedPointScale(cycles, m_nsPerCycle);
+            return static_cast<eerratic_tick_t>(ns / kNsPerTick);
+        }
+#endif
+        return eerratic_monotonic_time();
+    }
+
+    bool isTscEnabled() const { return m_tscEnabled; }
+
+    static eerratic_tick_t nowCtx(void* ctx) {
+        return static_cast<const EEerraticTscClock*>(ctx)->now();
+    }
+
+private:
+    static constexpr unsigned kShift = 32;      // fixedPointScale() assumes 32
+    static constexpr uint64_t kNsPerTick = 1000000000u / EERRATIC_TICKS_PER_SEC;
+
+    // Fixed-point math in 64 bits: 32-bit x86 has no unsigned __int128
+
+    // (numerator << kShift) / denominator, one fraction bit at a time; denominator < 2^63
+    static uint64_t fixedPointRatio(uint64_t numerator, uint64_t denominator) {
+        uint64_t ratio = numerator / denominator;
+        uint64_t remainder = numerator % denominator;
+        for (unsigned bit = 0; bit < kShift; bit++) {
+            remainder <<= 1;
+            ratio <<= 1;
+            if (remainder >= denominator) {
+                remainder -= denominator;
+                ratio |= 1;
+            }
+        }
+        return ratio;
+    }
+
+    // (value * factor) >> kShift from 32-bit halves
+    static uint64_t fixedPointScale(uint64_t value, uint64_t factor) {
+        const uint64_t mask = 0xffffffffu;
+        const uint64_t valueHigh = value >> 32, valueLow = value & mask;
+        const uint64_t factorHigh = factor >> 32, factorLow = factor & mask;
+        return ((valueHigh * factorHigh) << 32) + valueHigh * factorLow + valueLow * factorHigh
+            + ((valueLow * factorLow) >> 32);
+    }
+
+#ifdef EERRATIC_HAS_TSC
+    // CPUID.80000007H:EDX[8] reports a TSC with a constant rate in every power state
+    static bool hasInvariantTsc() {
+        unsigned int eax, ebx, ecx, edx;
+        if (__get_cpuid(0x80000000u, &eax, &ebx, &ecx, &edx) == 0 || eax < 0x80000007u) {
+            return false;
+        }
+        if (__get_cpuid(0x80000007u, &eax, &ebx, &ecx, &edx) == 0) {
+            return false;
+        }
+        return (edx & (1u << 8)) != 0;
+    }
+#endif
+
+    bool m_tscEnabled = false;
+    uint64_t m_nsPerCycle = 0;      // Fixed point with kShift fraction bits
+    uint64_t m_baseCycles = 0;
+    uint64_t m_baseNs = 0;
+};
+
+#endif // EERRATIC_TSC_CLOCK_HPP
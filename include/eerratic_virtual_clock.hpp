@@ -0,0 +1,163 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_VIRTUAL_CLOCK_HPP
+#define EERRATIC_VIRTUAL_CLOCK_HPP
+
+#include "eerratic_timer.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <deque>
+#include <type_traits>
+
+
+/**
+ * @brief Deterministic simulated time for running schedules without waiting
+ *
+ * sleep() advances the simulated time instantly. Events are scripted on the
+ * timeline with EEerraticVirtualClock::Event::setAt()/clearAt(), and every
+ * unsuccessful poll of an event costs pollCost ticks so that spinning waits
+ * make progress. Waits through the blocking backend (waitEvent) jump straight
+ * to the next transition or the timeout.
+ *
+ * The static *Ctx functions plug the clock into timer_utils_ctx_t; with
+ * EEerraticTimer, wrap the members in lambdas.
+ */
+class EEerraticVirtualClock {
+public:
+    class Event {
+    public:
+        explicit Event(EEerraticVirtualClock& clock) : m_clock(clock) {}
+
+        Event(const Event&) = delete;
+        Event& operator=(const Event&) = delete;
+
+        void setAt(eerratic_tick_t time) { addTransition(time, true); }
+        void clearAt(eerratic_tick_t time) { addTransition(time, false); }
+        void set() { setAt(m_clock.now()); }
+        void clear() { clearAt(m_clock.now()); }
+
+        /**
+         * @brief Check the event at the current simulated time (costs pollCost ticks when not set)
+         */
+        bool isSet() {
+            if (state()) {
+                return true;
+            }
+            m_clock.advance(m_clock.m_pollCost);
+            return state();
+        }
+
+        /**
+         * @brief Blocking wait backend: jump to the next time the event is set, at most timeout ticks
+         *
+         * @return true if the event is set afterwards
+         */
+        bool wait(eerratic_tick_t timeout) {
+            if (state()) {
+                return true;
+            }
+            const eerratic_tick_t now = m_clock.now();
+            for (const Transition& transition : m_transitions) {
+                eerratic_tick_t delay = transition.time - now;
+                if (transition.state && delay <= timeout) {
+                    m_clock.advance(delay);
+                    return state();
+                }
+            }
+            m_clock.advance(timeout);
+            return state();
+        }
+
+        static bool isSetCtx(void* ctx) {
+            return static_cast<Event*>(ctx)->isSet();
+        }
+
+        static bool waitCtx(void* ctx, eerratic_tick_t timeout) {
+            return static_cast<Event*>(ctx)->wait(timeout);
+        }
+
+    private:
+        struct Transition {
+            eerratic_tick_t time;
+            bool state;
+        };
+
+        void addTransition(eerratic_tick_t time, bool state) {
+            const eerratic_tick_t now = m_clock.now();
+            auto it = std::upper_bound(m_transitions.begin(), m_transitions.end(), time,
+                [now](eerratic_tick_t value, const Transition& transition) {
+                    return ticksFrom(now, value) < ticksFrom(now, transition.time);
+                });
+            m_transitions.insert(it, Transition{ time, state });
+        }
+
+        // Applies every transition that is due and returns the current state
+        bool state() {
+            const eerratic_tick_t now = m_clock.now();
+            while (!m_transitions.empty() && ticksFrom(now, m_transitions.front().time) <= 0) {
+                m_state = m_transitions.front().state;
+                m_transitions.pop_front();
+            }
+            return m_state;
+        }
+
+        EEerraticVirtualClock& m_clock;
+        std::deque<Transition> m_transitions;
+        bool m_state = false;
+    };
+
+    explicit EEerraticVirtualClock(eerratic_tick_t startTime = 0, eerratic_tick_t pollCost = 1)
+        : m_now(startTime), m_pollCost(pollCost) {}
+
+    eerratic_tick_t now() const { return m_now; }
+    void sleep(eerratic_tick_t ticks) { advance(ticks); }
+    void advance(eerratic_tick_t ticks) { m_now += ticks; m_advanced += ticks; }
+    void setPollCost(eerratic_tick_t pollCost) { m_pollCost = pollCost; }
+
+    /**
+     * @brief Total simulated time since construction (wrap-free)
+     */
+    uint64_t getSimulatedTime() const { return m_advanced; }
+
+    static eerratic_tick_t getCurrentTimeCtx(void* ctx) {
+        return static_cast<EEerraticVirtualClock*>(ctx)->now();
+    }
+
+    static void sleepCtx(void* ctx, eerratic_tick_t ticks) {
+        static_cast<EEerraticVirtualClock*>(ctx)->sleep(ticks);
+    }
+
+    /**
+     * @brief Fill the clock, sleep, event and blocking backend callbacks of timer_utils
+     *
+     * @param timer_utils The timer utils to bind
+     * @param event The event of the step (may be NULL)
+     */
+    void bind(timer_utils_ctx_t& timer_utils, Event* event) {
+        timer_utils.get_current_time_func = getCurrentTimeCtx;
+        timer_utils.time_ctx = this;
+        timer_utils.sleep_func = sleepCtx;
+        timer_utils.sleep_ctx = this;
+        timer_utils.is_event_set_func = event ? Event::isSetCtx : nullptr;
+        timer_utils.event_ctx = event;
+        timer_utils.wait_backend.wait_event_func = event ? Event::waitCtx : nullptr;
+        timer_utils.wait_backend.wait_event_ctx = event;
+    }
+
+private:
+    // Signed distance from one time to another, valid across wrap-around
+    static std::make_signed_t<eerratic_tick_t> ticksFrom(eerratic_tick_t from, eerratic_tick_t to) {
+        return static_cast<std::make_signed_t<eerratic_tick_t>>(to - from);
+    }
+
+    eerratic_tick_t m_now;
+    eerratic_tick_t m_pollCost;
+    uint64_t m_advanced = 0;
+};
+
+#endif // EERRATIC_VIRTUAL_CLOCK_HPP
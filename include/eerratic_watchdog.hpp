@@ -0,0 +1,149 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#ifndef EERRATIC_WATCHDOG_HPP
+#define EERRATIC_WATCHDOG_HPP
+
+#include "eerratic_callback.hpp"
+#include "eerratic_timer.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+
+/**
+ * @brief Reports step and loop deadline misses while they happen
+ *
+ * A blocking wait notices its deadline only between two calls of its event
+ * callback, so a callback that stalls (a slow bus read, a lock) overruns
+ * silently until it returns. Timers attached with
+ * EEerraticTimer::setWatchdog() publish the deadline of the running step and
+ * of the current loop to a channel; a monitor thread checks all channels
+ * every checkInterval ticks and calls the miss handlers on its own thread as
+ * soon as a deadline is more than tolerance ticks behind. Each step run and
+ * each loop is reported at most once.
+ *
+ * Publishing is a few atomic stores, so the timer thread never waits on the
+ * monitor. When a step or loop ends, its final overrun is recorded in the
+ * channel statistics, also if it ended before the monitor saw it.
+ * The time function is called from the monitor thread.
+ */
+class EEerraticWatchdog {
+public:
+    using TimeFunction = EEerraticCallback<eerratic_tick_t()>;
+
+    enum class MissKind {
+        Step,
+        Loop
+    };
+
+    struct Miss {
+        uint32_t channelId;         // As passed to setWatchdog()
+        int stepId;                 // Step or group id; -1 for loops
+        MissKind kind;
+        eerratic_tick_t deadline;
+        eerratic_tick_t detectedTime;
+        eerratic_tick_t overrun;    // detectedTime - deadline
+    };
+
+    // Called on the monitor thread; must not call into the watchdog
+    using MissHandler = EEerraticCallback<void(const Miss&)>;
+
+    struct ChannelStats {
+        uint64_t stepMisses;        // Reported by the monitor
+        uint64_t loopMisses;
+        uint64_t stepOverruns;      // Seen when the step or loop ended, beyond the tolerance
+        uint64_t loopOverruns;
+        eerratic_tick_t maxStepOverrun;
+        eerratic_tick_t maxLoopOverrun;
+    };
+
+    /**
+     * @brief Deadlines published by one timer (single writer: the timer thread)
+     */
+    class Channel {
+    public:
+        void beginStep(int stepId, eerratic_tick_t deadline) { m_step.arm(stepId, deadline); }
+        void endStep(eerratic_tick_t now);
+        void beginLoop(eerratic_tick_t deadline) { m_loop.arm(-1, deadline); }
+        void endLoop(eerratic_tick_t now);
+        // Withdraws both deadlines without recording anything
+        void disarm() { m_step.clear(); m_loop.clear(); }
+        uint32_t getId() const { return m_id; }
+        ChannelStats getStats() const;
+
+    private:
+        friend class EEerraticWatchdog;
+
+        // Seqlock-published deadline: the sequence is odd while it changes
+        struct Deadline {
+            std::atomic<uint32_t> seq{0};
+            std::atomic<bool> armed{false};
+            std::atomic<int> id{0};
+            std::atomic<eerratic_tick_t> deadline{0};
+            uint32_t reportedSeq = 0;       // Monitor thread only
+
+            void arm(int stepId, eerratic_tick_t time);
+            void clear();
+            // Final overrun, 0 if the deadline was kept or nothing was armed
+            eerratic_tick_t disarm(eerratic_tick_t now);
+        };
+
+        Channel(uint32_t id, eerratic_tick_t tolerance) : m_id(id), m_tolerance(tolerance) {}
+        void recordOverrun(eerratic_tick_t overrun, std::atomic<uint64_t>& count, std::atomic<eerratic_tick_t>& maximum);
+
+        uint32_t m_id;
+        eerratic_tick_t m_tolerance;
+        Deadline m_step;
+        Deadline m_loop;
+        std::atomic<uint64_t> m_stepMisses{0};
+        std::atomic<uint64_t> m_loopMisses{0};
+        std::atomic<uint64_t> m_stepOverruns{0};
+        std::atomic<uint64_t> m_loopOverruns{0};
+        std::atomic<eerratic_tick_t> m_maxStepOverrun{0};
+        std::atomic<eerratic_tick_t> m_maxLoopOverrun{0};
+    };
+
+    EEerraticWatchdog(TimeFunction, eerratic_tick_t checkInterval = EERRATIC_TICKS_PER_MS, eerratic_tick_t tolerance = 0);
+    ~EEerraticWatchdog();
+
+    EEerraticWatchdog(const EEerraticWatchdog&) = delete;
+    EEerraticWatchdog& operator=(const EEerraticWatchdog&) = delete;
+
+    // Handlers must be added before start()
+    void addHandler(MissHandler);
+    // The channel lives until removeChannel() or the end of the watchdog
+    Channel& addChannel(uint32_t id);
+    // Stops monitoring the channel and destroys it
+    void removeChannel(Channel&);
+    size_t getChannelCount() const;
+    void start();
+    void stop();
+
+private:
+    void monitorMain();
+    void check(Channel&, eerratic_tick_t now);
+    bool checkDeadline(Channel::Deadline&, eerratic_tick_t now, int& id, eerratic_tick_t& deadline) const;
+
+    TimeFunction m_getCurrentTimeFunc;
+    eerratic_tick_t m_checkInterval;
+    eerratic_tick_t m_tolerance;
+    std::vector<MissHandler> m_handlers;
+    std::vector<std::unique_ptr<Channel>> m_channels;
+    std::vector<Miss> m_misses;
+    std::thread m_monitor;
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cv;
+    bool m_running = false;
+};
+
+#endif // EERRATIC_WATCHDOG_HPP
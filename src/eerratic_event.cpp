@@ -0,0 +1,119 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "eerratic_event.hpp"
+
+#include <chrono>
+
+#ifdef EERRATIC_EVENT_USE_FUTEX
+#include <cerrno>
+#include <climits>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+Clock::duration ticksToDuration(eerratic_tick_t ticks) {
+    return std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(static_cast<double>(ticks) / EERRATIC_TICKS_PER_SEC));
+}
+
+#ifdef EERRATIC_EVENT_USE_FUTEX
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+
+uint32_t* futexWord(std::atomic<uint32_t>& state) {
+    return reinterpret_cast<uint32_t*>(&state);
+}
+
+// Sleeps while *word == expected, at most timeout; spurious returns are fine
+void futexWait(std::atomic<uint32_t>& state, uint32_t expected, Clock::duration timeout) {
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(timeout).count();
+    struct timespec relative;
+    relative.tv_sec = static_cast<time_t>(nanoseconds / 1000000000);
+    relative.tv_nsec = static_cast<long>(nanoseconds % 1000000000);
+    syscall(SYS_futex, futexWord(state), FUTEX_WAIT_PRIVATE, expected, &relative, nullptr, 0);
+}
+
+void futexWakeAll(std::atomic<uint32_t>& state) {
+    syscall(SYS_futex, futexWord(state), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+#endif
+
+}  // namespace
+
+
+void EEerraticEvent::set(eerratic_tick_t firedTime) {
+    // Published before the state, so a waiter that sees the event also sees its time
+    m_firedTime.store(firedTime, std::memory_order_relaxed);
+    m_hasFiredTime.store(true, std::memory_order_release);
+    signal();
+}
+
+bool EEerraticEvent::getFiredTime(eerratic_tick_t& firedTime) const {
+    if (!isSet() || !m_hasFiredTime.load(std::memory_order_acquire)) {
+        return false;
+    }
+    firedTime = m_firedTime.load(std::memory_order_relaxed);
+    return true;
+}
+
+void EEerraticEvent::set() {
+    m_hasFiredTime.store(false, std::memory_order_relaxed);
+    signal();
+}
+
+void EEerraticEvent::signal() {
+    if (m_state.exchange(1, std::memory_order_seq_cst) != 0) {
+        return;
+    }
+    if (m_waiters.load(std::memory_order_seq_cst) == 0) {
+        return;
+    }
+#ifdef EERRATIC_EVENT_USE_FUTEX
+    futexWakeAll(m_state);
+#else
+    // Taking the lock orders the wake after a waiter's check of the state
+    { std::lock_guard<std::mutex> lock(m_mutex); }
+    m_condition.notify_all();
+#endif
+}
+
+bool EEerraticEvent::wait(eerratic_tick_t timeout) {
+    if (isSet()) {
+        return true;
+    }
+    if (timeout == 0) {
+        return false;
+    }
+
+    const Clock::time_point deadline = Clock::now() + ticksToDuration(timeout);
+    m_waiters.fetch_add(1, std::memory_order_seq_cst);
+#ifdef EERRATIC_EVENT_USE_FUTEX
+    for (;;) {
+        if (m_state.load(std::memory_order_seq_cst) != 0) {
+            break;
+        }
+        const Clock::time_point now = Clock::now();
+        if (now >= deadline) {
+            break;
+        }
+        futexWait(m_state, 0, deadline - now);
+    }
+#else
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait_until(lock, deadline, [this] { return m_state.load(std::memory_order_seq_cst) != 0; });
+    }
+#endif
+    m_waiters.fetch_sub(1, std::memory_order_relaxed);
+    return isSet();
+}
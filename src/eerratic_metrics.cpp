@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "eerratic_metrics.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+
+namespace {
+
+size_t fileSize(uint32_t stepCapacity) {
+    return sizeof(EEerraticMetricsHeader) + static_cast<size_t>(stepCapacity) * sizeof(EEerraticMetricsStep);
+}
+
+std::runtime_error systemError(const std::string& what, const std::string& path) {
+    return std::runtime_error(what + " " + path + ": " + std::strerror(errno));
+}
+
+// Seqlock write side: odd while the fields change
+void beginWrite(std::atomic<uint32_t>& seq) {
+    seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+}
+
+void endWrite(std::atomic<uint32_t>& seq) {
+    seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+// A writer that dies mid-update leaves its sequence odd for good
+const int kReadAttempts = 10000;
+
+// Seqlock read side: copies until an even, unchanged sequence brackets the copy.
+// Yields between attempts and gives up after kReadAttempts, returning false with
+// a copy that may be torn.
+template <typename Copy>
+bool readConsistent(const std::atomic<uint32_t>& seq, Copy&& copy) {
+    for (int attempt = 0; attempt < kReadAttempts; attempt++) {
+        const uint32_t before = seq.load(std::memory_order_acquire);
+        if ((before & 1u) == 0) {
+            copy();
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq.load(std::memory_order_relaxed) == before) {
+                return true;
+            }
+        }
+        std::this_thread::yield();
+    }
+    copy();
+    return false;
+}
+
+void addRelaxed(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void maxRelaxed(std::atomic<uint64_t>& maximum, uint64_t value) {
+    if (value > maximum.load(std::memory_order_relaxed)) {
+        maximum.store(value, std::memory_order_relaxed);
+    }
+}
+
+} // namespace
+
+
+EEerraticMetricsExporter::EEerraticMetricsExporter(const std::string& path, uint32_t stepCapacity)
+    : m_size(fileSize(stepCapacity))
+{
+    const int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        throw systemError("cannot create", path);
+    }
+    if (ftruncate(fd, static_cast<off_t>(m_size)) != 0) {
+        close(fd);
+        throw systemError("cannot size", path);
+    }
+    void* memory = mmap(nullptr, m_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        throw systemError("cannot map", path);
+    }
+
+    // The file starts zeroed; construct the atomics in place and publish the magic last
+    m_header = new (memory) EEerraticMetricsHeader();
+    m_steps = reinterpret_cast<EEerraticMetricsStep*>(static_cast<char*>(memory) + sizeof(EEerraticMetricsHeader));
+    for (uint32_t slot = 0; slot < stepCapacity; slot++) {
+        new (&m_steps[slot]) EEerraticMetricsStep();
+    }
+    m_header->version = kEEerraticMetricsVersion;
+    m_header->stepCapacity = stepCapacity;
+    m_header->ticksPerSec = EERRATIC_TICKS_PER_SEC;
+    std::atomic_thread_fence(std::memory_order_release);
+    m_header->magic = kEEerraticMetricsMagic;
+}
+
+EEerraticMetricsExporter::~EEerraticMetricsExporter() {
+    munmap(m_header, m_size);
+}
+
+void EEerraticMetricsExporter::recordStep(uint32_t slot, int stepId, eerratic_tick_t elapsed, ERROR_CODE result) {
+    if (slot >= m_header->stepCapacity) {
+        return;
+    }
+    EEerraticMetricsStep& step = m_steps[slot];
+    beginWrite(step.seq);
+    step.stepId.store(stepId, std::memory_order_relaxed);
+    addRelaxed(step.count, 1);
+    if (result == ERROR_CODE_TIMEOUT || result == ERROR_CODE_TOTAL_TIMEOUT) {
+        addRelaxed(step.timeoutCount, 1);
+    }
+    step.lastElapsed.store(elapsed, std::memory_order_relaxed);
+    maxRelaxed(step.maxElapsed, elapsed);
+    endWrite(step.seq);
+
+    if (slot >= m_header->stepCount.load(std::memory_order_relaxed)) {
+        m_header->stepCount.store(slot + 1, std::memory_order_release);
+    }
+}
+
+void EEerraticMetricsExporter::recordLoop(eerratic_tick_t elapsed, bool overrun) {
+    beginWrite(m_header->loopSeq);
+    addRelaxed(m_header->loopCount, 1);
+    if (overrun) {
+        addRelaxed(m_header->loopOverrunCount, 1);
+    }
+    m_header->lastLoopElapsed.store(elapsed, std::memory_order_relaxed);
+    maxRelaxed(m_header->maxLoopElapsed, elapsed);
+    endWrite(m_header->loopSeq);
+}
+
+EEerraticMetricsReader::EEerraticMetricsReader(const std::string& path) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw systemError("cannot open", path);
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0 || static_cast<size_t>(status.st_size) < sizeof(EEerraticMetricsHeader)) {
+        close(fd);
+        throw std::runtime_error("not a metrics file: " + path);
+    }
+    m_size = static_cast<size_t>(status.st_size);
+    void* memory = mmap(nullptr, m_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (memory == MAP_FAILED) {
+        throw systemError("cannot map", path);
+    }
+
+    m_header = static_cast<const EEerraticMetricsHeader*>(memory);
+    m_steps = reinterpret_cast<const EEerraticMetricsStep*>(static_cast<const char*>(memory) + sizeof(EEerraticMetricsHeader));
+    // The header is writable by anyone who can write the file: take the capacity once,
+    // and only if the mapping holds that many slots
+    m_stepCapacity = m_header->stepCapacity;
+    const size_t mappedSlots = (m_size - sizeof(EEerraticMetricsHeader)) / sizeof(EEerraticMetricsStep);
+    if (m_header->magic != kEEerraticMetricsMagic || m_header->version != kEEerraticMetricsVersion
+        || m_stepCapacity > mappedSlots) {
+        munmap(memory, m_size);
+        throw std::runtime_error("not a metrics file: " + path);
+    }
+}
+
+EEerraticMetricsReader::~EEerraticMetricsReader() {
+    munmap(const_cast<EEerraticMetricsHeader*>(m_header), m_size);
+}
+
+uint64_t EEerraticMetricsReader::getTicksPerSec() const {
+    return m_header->ticksPerSec;
+}
+
+uint32_t EEerraticMetricsReader::getStepCount() const {
+    const uint32_t stepCount = m_header->stepCount.load(std::memory_order_acquire);
+    return stepCount < m_stepCapacity ? stepCount : m_stepCapacity;
+}
+
+bool EEerraticMetricsReader::readStep(uint32_t slot, StepSnapshot& snapshot) const {
+    // getStepCount() is bounded by the mapped capacity
+    if (slot >= getStepCount()) {
+        return false;
+    }
+    const EEerraticMetricsStep& step = m_steps[slot];
+    snapshot.torn = !readConsistent(step.seq, [&] {
+        snapshot.stepId = step.stepId.load(std::memory_order_relaxed);
+        snapshot.count = step.count.load(std::memory_order_relaxed);
+        snapshot.timeoutCount = step.timeoutCount.load(std::memory_order_relaxed);
+        snapshot.lastElapsed = step.lastElapsed.load(std::memory_order_relaxed);
+        snapshot.maxElapsed = step.maxElapsed.load(std::memory_order_relaxed);
+    });
+    return true;
+}
+
+EEerraticMetricsReader::LoopSnapshot EEerraticMetricsReader::readLoop() const {
+    LoopSnapshot snapshot{};
+    snapshot.torn = !readConsistent(m_header->loopSeq, [&] {
+        snapshot.loopCount = m_header->loopCount.load(std::memory_order_relaxed);
+        snapshot.loopOverrunCount = m_header->loopOverrunCount.load(std::memory_order_relaxed);
+        snapshot.lastLoopElapsed = m_header->lastLoopElapsed.load(std::memory_order_relaxed);
+        snapshot.maxLoopElapsed = m_header->maxLoopElapsed.load(std::memory_order_relaxed);
+    });
+    return snapshot;
+}
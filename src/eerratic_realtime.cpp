@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "eerratic_realtime.hpp"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <unistd.h>
+#endif
+
+
+namespace {
+
+using Status = EEerraticRealtime::Status;
+using Setting = EEerraticRealtime::Setting;
+
+Setting applied() {
+    return Setting{ Status::Applied, 0 };
+}
+
+Setting failed(int error) {
+    return Setting{ Status::Failed, error };
+}
+
+const char* statusName(Status status) {
+    switch (status) {
+    case Status::NotRequested: return "not requested";
+    case Status::Applied: return "applied";
+    case Status::Partial: return "partial";
+    case Status::Failed: return "failed";
+    case Status::Unsupported: return "unsupported";
+    }
+    return "unknown";
+}
+
+#ifdef __linux__
+Setting applyAffinity(const std::vector<int>& cpus) {
+    cpu_set_t requested;
+    CPU_ZERO(&requested);
+    for (int cpu : cpus) {
+        if (cpu < 0 || cpu >= CPU_SETSIZE) {
+            return failed(EINVAL);
+        }
+        CPU_SET(cpu, &requested);
+    }
+    int error = pthread_setaffinity_np(pthread_self(), sizeof(requested), &requested);
+    if (error != 0) {
+        return failed(error);
+    }
+    cpu_set_t actual;
+    error = pthread_getaffinity_np(pthread_self(), sizeof(actual), &actual);
+    if (error != 0) {
+        return failed(error);
+    }
+    return CPU_EQUAL(&requested, &actual) ? applied() : failed(EINVAL);
+}
+
+Setting applyPriority(int priority) {
+    sched_param param{};
+    param.sched_priority = priority;
+    int error = pthread_setschedparam(pthread_self(), SCHED_FIFO, &param);
+    if (error != 0) {
+        return failed(error);
+    }
+    int policy = 0;
+    error = pthread_getschedparam(pthread_self(), &policy, &param);
+    if (error != 0) {
+        return failed(error);
+    }
+    return (policy == SCHED_FIFO && param.sched_priority == priority) ? applied() : failed(EPERM);
+}
+
+Setting applyTimerSlack(unsigned long timerSlackNs) {
+    if (prctl(PR_SET_TIMERSLACK, timerSlackNs, 0, 0, 0) != 0) {
+        return failed(errno);
+    }
+    const int actual = prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+    if (actual < 0) {
+        return failed(errno);
+    }
+    return static_cast<unsigned long>(actual) == timerSlackNs ? applied() : failed(EINVAL);
+}
+
+Setting applyMemoryLock() {
+    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0) {
+        return failed(errno);
+    }
+    return applied();
+}
+
+// Left untouched below the pre-faulted region for this frame and signal handlers
+const size_t kStackReserve = 16 * 1024;
+
+// Stack between the current frame and the end of the thread's stack mapping
+Setting getRemainingStack(size_t& remaining) {
+    pthread_attr_t attr;
+    int error = pthread_getattr_np(pthread_self(), &attr);
+    if (error != 0) {
+        return failed(error);
+    }
+    void* stackAddr = nullptr;
+    size_t stackSize = 0;
+    error = pthread_attr_getstack(&attr, &stackAddr, &stackSize);
+    pthread_attr_destroy(&attr);
+    if (error != 0) {
+        return failed(error);
+    }
+    // The stack grows down towards stackAddr
+    const uintptr_t lowest = reinterpret_cast<uintptr_t>(stackAddr);
+    const uintptr_t current = reinterpret_cast<uintptr_t>(__builtin_frame_address(0));
+    remaining = current > lowest ? current - lowest : 0;
+    return applied();
+}
+
+// Not inlined, so the touched frame is really below the caller's stack
+__attribute__((noinline)) Setting prefaultStack(size_t bytes) {
+    size_t remaining = 0;
+    Setting setting = getRemainingStack(remaining);
+    if (setting.status != Status::Applied) {
+        return setting;
+    }
+    if (remaining <= kStackReserve) {
+        return failed(ENOMEM);
+    }
+    if (bytes > remaining - kStackReserve) {
+        bytes = remaining - kStackReserve;
+        setting = Setting{ Status::Partial, ENOMEM };
+    }
+
+    volatile unsigned char* stack = static_cast<volatile unsigned char*>(__builtin_alloca(bytes));
+    const size_t pageSize = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    for (size_t offset = 0; offset < bytes; offset += pageSize) {
+        stack[offset] = 0;
+    }
+    stack[bytes - 1] = 0;
+
+    // Read back which of the touched pages are resident
+    const uintptr_t begin = reinterpret_cast<uintptr_t>(stack) & ~(static_cast<uintptr_t>(pageSize) - 1);
+    const size_t length = reinterpret_cast<uintptr_t>(stack) + bytes - begin;
+    std::vector<unsigned char> residency((length + pageSize - 1) / pageSize);
+    if (mincore(reinterpret_cast<void*>(begin), length, residency.data()) != 0) {
+        return failed(errno);
+    }
+    for (unsigned char page : residency) {
+        if ((page & 1) == 0) {
+            return failed(EFAULT);
+        }
+    }
+    return setting;
+}
+#endif
+
+void describeSetting(std::string& out, const char* name, const Setting& setting) {
+    if (setting.status == Status::NotRequested) {
+        return;
+    }
+    out += name;
+    out += ": ";
+    out += statusName(setting.status);
+    if ((setting.status == Status::Failed || setting.status == Status::Partial) && setting.error != 0) {
+        out += " (";
+        out += std::strerror(setting.error);
+        out += ")";
+    }
+    out += "\n";
+}
+
+} // namespace
+
+
+bool EEerraticRealtime::Report::allApplied() const {
+    for (const Setting* setting : { &affinity, &priority, &timerSlack, &memoryLock, &stackPrefault }) {
+        if (setting->status != Status::NotRequested && setting->status != Status::Applied) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string EEerraticRealtime::Report::describe() const {
+    std::string out;
+    describeSetting(out, "affinity", affinity);
+    describeSetting(out, "priority", priority);
+    describeSetting(out, "timer_slack", timerSlack);
+    describeSetting(out, "memory_lock", memoryLock);
+    describeSetting(out, "stack_prefault", stackPrefault);
+    return out;
+}
+
+EEerraticRealtime::Report EEerraticRealtime::apply(const Config& config) {
+    Report report;
+#ifdef __linux__
+    // Memory first, so the pre-faulted stack pages stay locked
+    if (config.lockMemory) {
+        report.memoryLock = applyMemoryLock();
+    }
+    if (config.prefaultStackBytes > 0) {
+        report.stackPrefault = prefaultStack(config.prefaultStackBytes);
+    }
+    if (!config.cpus.empty()) {
+        report.affinity = applyAffinity(config.cpus);
+    }
+    if (config.timerSlackNs > 0) {
+        report.timerSlack = applyTimerSlack(config.timerSlackNs);
+    }
+    if (config.fifoPriority > 0) {
+        report.priority = applyPriority(config.fifoPriority);
+    }
+#else
+    const Setting unsupported{ Status::Unsupported, 0 };
+    report.memoryLock = config.lockMemory ? unsupported : Setting{};
+    report.stackPrefault = config.prefaultStackBytes > 0 ? unsupported : Setting{};
+    report.affinity = !config.cpus.empty() ? unsupported : Setting{};
+    report.timerSlack = config.timerSlackNs > 0 ? unsupported : Setting{};
+    report.priority = config.fifoPriority > 0 ? unsupported : Setting{};
+#endif
+    return report;
+}
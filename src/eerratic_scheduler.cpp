@@ -0,0 +1,292 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "eerratic_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <type_traits>
+
+
+namespace {
+
+using tick_duration_t = std::chrono::duration<int64_t, std::ratio<1, EERRATIC_TICKS_PER_SEC>>;
+
+// Upper bound on how long an idle worker parks before re-checking the queue
+const std::chrono::milliseconds kIdleWait(100);
+
+// Wrap-safe ordering of two tick values
+bool tickBefore(eerratic_tick_t lhs, eerratic_tick_t rhs) {
+    return static_cast<std::make_signed_t<eerratic_tick_t>>(lhs - rhs) < 0;
+}
+
+} // namespace
+
+
+EEerraticScheduler::EEerraticScheduler(size_t workerCount,
+            TimeFunction getTimeFunc,
+            eerratic_tick_t pollInterval)
+    : m_getCurrentTimeFunc(getTimeFunc),
+      m_pollInterval(pollInterval ? pollInterval : 1),
+      m_workerCount(workerCount)
+{
+    if (!m_getCurrentTimeFunc) {
+        throw std::invalid_argument("get_current_time_func is null");
+    }
+    if (workerCount == 0) {
+        throw std::invalid_argument("worker count must be positive");
+    }
+}
+
+EEerraticScheduler::~EEerraticScheduler() {
+    stop();
+}
+
+EEerraticScheduler::LoopHandle EEerraticScheduler::addLoop(eerratic_tick_t loopExpectedElapsedTime,
+            StepDoneFunction onStepDone)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        throw std::logic_error("loops must be added before start()");
+    }
+    std::unique_ptr<Loop> loop(new Loop());
+    loop->loopExpectedElapsedTime = loopExpectedElapsedTime;
+    loop->onStepDone = onStepDone;
+    m_loops.push_back(std::move(loop));
+    return LoopHandle{ static_cast<uint32_t>(m_loops.size() - 1) };
+}
+
+void EEerraticScheduler::addStep(LoopHandle handle,
+            int id,
+            eerratic_tick_t expectedElapsedTime,
+            EventFunction isEventSetFunc,
+            sleep_type_t sleepType)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        throw std::logic_error("steps must be added before start()");
+    }
+    if (sleepType == WAIT_ANY_EVENT || sleepType == WAIT_ALL_EVENTS) {
+        throw std::invalid_argument("event set steps are not supported by the scheduler");
+    }
+    if ((sleepType == WAIT_EVENT || sleepType == WAIT_TIME_AND_EVENT) && !isEventSetFunc) {
+        throw std::invalid_argument("is_event_set_func is null");
+    }
+    loopAt(handle).steps.push_back({ id, expectedElapsedTime, isEventSetFunc, sleepType });
+}
+
+void EEerraticScheduler::setRealtimeConfig(const EEerraticRealtime::Config& config) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        throw std::logic_error("the realtime config must be set before start()");
+    }
+    m_realtimeConfig = config;
+    m_hasRealtimeConfig = true;
+}
+
+void EEerraticScheduler::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+
+    const eerratic_tick_t now = m_getCurrentTimeFunc();
+    m_queue.clear();
+    m_queue.reserve(m_loops.size());
+    for (uint32_t i = 0; i < m_loops.size(); i++) {
+        Loop& loop = *m_loops[i];
+        if (loop.steps.empty()) {
+            continue;
+        }
+        loop.loopStartTime = now;
+        loop.stepIndex = 0;
+        step_poll_begin(&loop.poll, loop.steps[0].expectedElapsedTime, loop.steps[0].sleepType, now);
+        pushEntry({ now, i, false });
+    }
+
+    m_realtimeReports.assign(m_hasRealtimeConfig ? m_workerCount : 0, EEerraticRealtime::Report{});
+    m_realtimeApplied = 0;
+    m_workers.reserve(m_workerCount);
+    for (size_t i = 0; i < m_workerCount; i++) {
+        m_workers.emplace_back([this, i] {
+            applyRealtime(i);
+            workerMain();
+        });
+    }
+
+    // Reports are complete when start() returns; the workers do not need m_mutex for this
+    if (m_hasRealtimeConfig) {
+        std::unique_lock<std::mutex> realtimeLock(m_realtimeMutex);
+        m_realtimeCv.wait(realtimeLock, [this] { return m_realtimeApplied == m_workerCount; });
+    }
+}
+
+void EEerraticScheduler::applyRealtime(size_t workerIndex) {
+    if (!m_hasRealtimeConfig) {
+        return;
+    }
+    EEerraticRealtime::Config config = m_realtimeConfig;
+    if (config.cpus.size() > 1) {
+        config.cpus = { config.cpus[workerIndex % config.cpus.size()] };
+    }
+    m_realtimeReports[workerIndex] = EEerraticRealtime::apply(config);
+
+    std::lock_guard<std::mutex> lock(m_realtimeMutex);
+    m_realtimeApplied++;
+    m_realtimeCv.notify_one();
+}
+
+std::vector<EEerraticRealtime::Report> EEerraticScheduler::getRealtimeReports() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_realtimeReports;
+}
+
+void EEerraticScheduler::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+    }
+    m_cv.notify_all();
+    for (std::thread& worker : m_workers) {
+        worker.join();
+    }
+    m_workers.clear();
+    m_hasTimedWaiter = false;
+}
+
+void EEerraticScheduler::notify() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        const eerratic_tick_t now = m_getCurrentTimeFunc();
+        bool changed = false;
+        for (Entry& entry : m_queue) {
+            if (entry.waitsForEvent && tickBefore(now, entry.wakeTime)) {
+                entry.wakeTime = now;
+                changed = true;
+            }
+        }
+        if (!changed) {
+            return;
+        }
+        std::make_heap(m_queue.begin(), m_queue.end(), [](const Entry& lhs, const Entry& rhs) {
+            return tickBefore(rhs.wakeTime, lhs.wakeTime);
+        });
+    }
+    m_cv.notify_all();
+}
+
+uint64_t EEerraticScheduler::getLoopCount(LoopHandle handle) const {
+    return loopAt(handle).loopCount.load(std::memory_order_relaxed);
+}
+
+uint64_t EEerraticScheduler::getTimeoutCount(LoopHandle handle) const {
+    return loopAt(handle).timeoutCount.load(std::memory_order_relaxed);
+}
+
+size_t EEerraticScheduler::getWorkerCount() const {
+    return m_workerCount;
+}
+
+EEerraticScheduler::Loop& EEerraticScheduler::loopAt(LoopHandle handle) const {
+    if (handle.index >= m_loops.size()) {
+        throw std::out_of_range("invalid loop handle");
+    }
+    return *m_loops[handle.index];
+}
+
+void EEerraticScheduler::pushEntry(const Entry& entry) {
+    m_queue.push_back(entry);
+    std::push_heap(m_queue.begin(), m_queue.end(), [](const Entry& lhs, const Entry& rhs) {
+        return tickBefore(rhs.wakeTime, lhs.wakeTime);
+    });
+}
+
+// Leader/follower: at most one worker sleeps until the earliest deadline,
+// the others wait untimed until they are handed the lead.
+void EEerraticScheduler::workerMain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        if (m_queue.empty() || m_hasTimedWaiter) {
+            m_cv.wait_for(lock, kIdleWait);
+            continue;
+        }
+
+        const eerratic_tick_t now = m_getCurrentTimeFunc();
+        const Entry next = m_queue.front();
+        if (tickBefore(now, next.wakeTime)) {
+            m_hasTimedWaiter = true;
+            m_cv.wait_for(lock, tick_duration_t(static_cast<int64_t>(next.wakeTime - now)));
+            m_hasTimedWaiter = false;
+            continue;
+        }
+
+        std::pop_heap(m_queue.begin(), m_queue.end(), [](const Entry& lhs, const Entry& rhs) {
+            return tickBefore(rhs.wakeTime, lhs.wakeTime);
+        });
+        m_queue.pop_back();
+        // Another worker may now take the lead on the remaining entries
+        m_cv.notify_one();
+
+        lock.unlock();
+        Entry entry = runLoop(next.loopIndex, now);
+        lock.lock();
+
+        pushEntry(entry);
+        if (m_queue.front().loopIndex == entry.loopIndex) {
+            // New earliest deadline: the current leader must re-arm its wait
+            m_cv.notify_all();
+        }
+    }
+}
+
+// Advances one loop as far as it can go without blocking and returns when
+// it has to be looked at again.
+EEerraticScheduler::Entry EEerraticScheduler::runLoop(uint32_t loopIndex, eerratic_tick_t now) {
+    Loop& loop = *m_loops[loopIndex];
+    timer_utils_ctx_t timerUtils{};
+
+    while (true) {
+        const Step& step = loop.steps[loop.stepIndex];
+        timerUtils.is_event_set_func = step.isEventSetFunc.invoker();
+        timerUtils.event_ctx = step.isEventSetFunc.target();
+
+        eerratic_tick_t wakeTime = now;
+        ERROR_CODE result = step_poll(&loop.poll, loop.loopStartTime, loop.loopExpectedElapsedTime, now, &timerUtils, &wakeTime);
+        if (result == ERROR_CODE_PENDING) {
+            bool waitsForEvent = !loop.poll.event_seen
+                && (step.sleepType == WAIT_EVENT || step.sleepType == WAIT_TIME_AND_EVENT);
+            if (waitsForEvent && tickBefore(now + m_pollInterval, wakeTime)) {
+                wakeTime = now + m_pollInterval;
+            }
+            return Entry{ wakeTime, loopIndex, waitsForEvent };
+        }
+
+        if (result == ERROR_CODE_TIMEOUT) {
+            loop.timeoutCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        if (loop.onStepDone) {
+            loop.onStepDone(step.id, result, loop.poll.elapsed_time);
+        }
+
+        now = m_getCurrentTimeFunc();
+        bool loopDone = (++loop.stepIndex == loop.steps.size());
+        if (loopDone) {
+            loop.stepIndex = 0;
+            loop.loopStartTime = now;
+            loop.loopCount.fetch_add(1, std::memory_order_relaxed);
+        }
+        const Step& nextStep = loop.steps[loop.stepIndex];
+        step_poll_begin(&loop.poll, nextStep.expectedElapsedTime, nextStep.sleepType, now);
+        if (loopDone) {
+            // Give the other loops a turn between iterations
+            return Entry{ now, loopIndex, false };
+        }
+    }
+}
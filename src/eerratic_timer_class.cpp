@@ -6,45 +6,938 @@
 
 #include "eerratic_timer_class.hpp"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
 
-EEerraticTimer::EEerraticTimer(uint32_t loopExpectedElapsedTime,
-            get_current_time_func_t getTimeFunc,
-            sleep_func_t sleepFunc)
-    : m_loopExpectedElapsedTime(loopExpectedElapsedTime)
+
+static void yield_impl() {
+    std::this_thread::yield();
+}
+
+// Lower rank wins when the member results of a group are combined
+static int resultRank(ERROR_CODE result) {
+    switch (result) {
+    case ERROR_CODE_OK: return 3;
+    case ERROR_CODE_TIMEOUT: return 2;
+    case ERROR_CODE_TOTAL_TIMEOUT: return 1;
+    default: return 0;
+    }
+}
+
+/**
+ * @brief Threads that run the members of a parallel group
+ *
+ * The calling thread runs members too, so a group of N members needs N - 1
+ * workers. Members are claimed through an atomic index; the caller waits
+ * until all of them finished.
+ */
+struct EEerraticTimer::GroupWorkers {
+    std::mutex mutex;
+    std::condition_variable wakeCv;
+    std::condition_variable doneCv;
+    std::vector<std::thread> threads;
+    EEerraticTimer* timer = nullptr;
+    Group* group = nullptr;
+    uint64_t generation = 0;
+    size_t remaining = 0;
+    size_t activeWorkers = 0;  // Workers inside claimMembers(), the run waits for them to leave
+    std::atomic<size_t> nextMember{ 0 };
+    bool stopping = false;
+
+    ~GroupWorkers() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeCv.notify_all();
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+    }
+
+    void reserve(size_t workerCount) {
+        while (threads.size() < workerCount) {
+            threads.emplace_back([this] { workerMain(); });
+        }
+    }
+
+    void run(EEerraticTimer* runTimer, Group* runGroup) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            timer = runTimer;
+            group = runGroup;
+            remaining = runGroup->slots.size();
+            nextMember.store(0, std::memory_order_relaxed);
+            generation++;
+        }
+        wakeCv.notify_all();
+        claimMembers(runTimer, runGroup);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        doneCv.wait(lock, [this] { return remaining == 0 && activeWorkers == 0; });
+        group = nullptr;
+    }
+
+    void claimMembers(EEerraticTimer* runTimer, Group* runGroup) {
+        const size_t memberCount = runGroup->slots.size();
+        size_t member;
+        while ((member = nextMember.fetch_add(1, std::memory_order_relaxed)) < memberCount) {
+            runTimer->runGroupMember(*runGroup, member);
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--remaining == 0) {
+                doneCv.notify_one();
+            }
+        }
+    }
+
+    void workerMain() {
+        uint64_t seenGeneration = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;) {
+            wakeCv.wait(lock, [&] { return stopping || (group != nullptr && generation != seenGeneration); });
+            if (stopping) {
+                return;
+            }
+            seenGeneration = generation;
+            EEerraticTimer* runTimer = timer;
+            Group* runGroup = group;
+            activeWorkers++;
+            lock.unlock();
+            claimMembers(runTimer, runGroup);
+            lock.lock();
+            if (--activeWorkers == 0 && remaining == 0) {
+                doneCv.notify_one();
+            }
+        }
+    }
+};
+
+
+EEerraticTimer::EEerraticTimer(eerratic_tick_t loopExpectedElapsedTime,
+            TimeFunction getTimeFunc,
+            SleepFunction sleepFunc)
+    : m_getCurrentTimeFunc(getTimeFunc),
+      m_sleepFunc(sleepFunc),
+      m_loopExpectedElapsedTime(loopExpectedElapsedTime)
 {
-    if (!getTimeFunc) {
+    if (!m_getCurrentTimeFunc) {
         throw std::invalid_argument("get_current_time_func is null");
     }
-    m_timerUtils.get_current_time_func = getTimeFunc;
-    m_timerUtils.sleep_func = sleepFunc;
 }
 
-void EEerraticTimer::addStep(int id,
-            uint32_t expectedElapsedTime,
-            is_event_set_func_t isEventSetFunc,
+EEerraticTimer::~EEerraticTimer() = default;
+EEerraticTimer::EEerraticTimer(EEerraticTimer&&) noexcept = default;
+EEerraticTimer& EEerraticTimer::operator=(EEerraticTimer&&) noexcept = default;
+
+EEerraticTimer::StepHandle EEerraticTimer::addStep(int id,
+            eerratic_tick_t expectedElapsedTime,
+            EventFunction isEventSetFunc,
+            sleep_type_t sleepType,
+            wait_policy_t waitPolicy,
+            WaitEventFunction waitEventFunc)
+{
+    uint32_t slot = findStep(id);
+    if (slot == kNoStep) {
+        slot = static_cast<uint32_t>(m_stepConfigs.size());
+        auto it = std::lower_bound(m_stepIndex.begin(), m_stepIndex.end(), id, isBefore);
+        m_stepIndex.insert(it, StepIndexEntry{ id, slot });
+        m_stepConfigs.emplace_back();
+        m_stepStats.emplace_back();
+        m_stepIds.push_back(id);
+        m_preciseSleeps.emplace_back();
+        m_eventSets.emplace_back();
+    }
+
+    m_stepConfigs[slot] = { expectedElapsedTime, isEventSetFunc, sleepType, waitPolicy, waitEventFunc, nullptr, nullptr, 0 };
+    m_stepStats[slot].reset();
+    precise_sleep_init(&m_preciseSleeps[slot]);
+    m_eventSets[slot] = event_set_t{};
+    return StepHandle{ slot };
+}
+
+EEerraticTimer::StepHandle EEerraticTimer::addStep(int id,
+            eerratic_tick_t expectedElapsedTime,
+            EEerraticEvent& event,
             sleep_type_t sleepType)
 {
-    m_steps[id] = { expectedElapsedTime, isEventSetFunc, sleepType };
+    if (sleepType != WAIT_EVENT && sleepType != WAIT_TIME_AND_EVENT) {
+        throw std::invalid_argument("event steps must be WAIT_EVENT or WAIT_TIME_AND_EVENT");
+    }
+    EEerraticEvent* eventPtr = &event;
+    StepHandle handle = addStep(id, expectedElapsedTime, [eventPtr] { return eventPtr->isSet(); }, sleepType,
+                                WAIT_POLICY_BLOCK, [eventPtr](eerratic_tick_t timeout) { return eventPtr->wait(timeout); });
+    m_stepConfigs[handle.index].getEventTimeFunc = [eventPtr](eerratic_tick_t& firedTime) {
+        return eventPtr->getFiredTime(firedTime);
+    };
+    return handle;
+}
+
+EEerraticTimer::StepHandle EEerraticTimer::addStep(int id,
+            eerratic_tick_t expectedElapsedTime,
+            EventMaskFunction getEventMaskFunc,
+            uint32_t waitMask,
+            sleep_type_t sleepType,
+            wait_policy_t waitPolicy,
+            WaitEventFunction waitEventFunc)
+{
+    if (sleepType != WAIT_ANY_EVENT && sleepType != WAIT_ALL_EVENTS) {
+        throw std::invalid_argument("event mask steps must be WAIT_ANY_EVENT or WAIT_ALL_EVENTS");
+    }
+    if (!getEventMaskFunc) {
+        throw std::invalid_argument("get_event_mask_func is null");
+    }
+    if (waitMask == 0) {
+        throw std::invalid_argument("wait mask is empty");
+    }
+
+    StepHandle handle = addStep(id, expectedElapsedTime, nullptr, sleepType, waitPolicy, waitEventFunc);
+    m_stepConfigs[handle.index].getEventMaskFunc = getEventMaskFunc;
+    m_eventSets[handle.index].wait_mask = waitMask;
+    return handle;
 }
 
 void EEerraticTimer::resetLoop() {
-    m_loopStartTime = m_timerUtils.get_current_time_func();
+    const eerratic_tick_t now = m_getCurrentTimeFunc();
+    endLoop(now);
+    m_loopStartTime = now;
+    m_slack = 0;
+    beginLoop();
+}
+
+// Measures the loop that ends now, if one was started
+void EEerraticTimer::endLoop(eerratic_tick_t now) {
+    if (m_loopActive) {
+        const eerratic_tick_t loopElapsed = now - m_loopStartTime;
+        m_loopHistogram.record(loopElapsed - std::min(m_loopRemainderTime, loopElapsed));
+        if (m_metricsExporter) {
+            m_metricsExporter->recordLoop(loopElapsed, loopElapsed > m_loopExpectedElapsedTime);
+        }
+    }
+    if (m_watchdog.channel) {
+        m_watchdog.channel->endLoop(now);
+    }
+    m_loopActive = true;
+    m_loopRemainderTime = 0;
+}
+
+// Publishes the deadline of the loop that starts at m_loopStartTime
+void EEerraticTimer::beginLoop() {
+    if (m_watchdog.channel) {
+        m_watchdog.channel->beginLoop(m_loopStartTime + m_loopExpectedElapsedTime);
+    }
+}
+
+void EEerraticTimer::startPeriodic(OverrunPolicy overrunPolicy) {
+    m_overrunPolicy = overrunPolicy;
+    m_missedPeriodCount = 0;
+    m_latePeriodCount = 0;
+    m_loopStartTime = m_getCurrentTimeFunc();
+    m_loopActive = true;
+    m_slack = 0;
+    beginLoop();
+}
+
+ERROR_CODE EEerraticTimer::nextPeriod() {
+    using signed_tick_t = std::make_signed_t<eerratic_tick_t>;
+    const eerratic_tick_t period = m_loopExpectedElapsedTime;
+    const eerratic_tick_t nextStartTime = m_loopStartTime + period;
+    eerratic_tick_t now = m_getCurrentTimeFunc();
+    m_slack = 0;
+    endLoop(now);
+
+    if (static_cast<signed_tick_t>(now - nextStartTime) < 0) {
+        if (m_sleepFunc) {
+            m_sleepFunc(nextStartTime - now);
+            now = m_getCurrentTimeFunc();
+        }
+        while (static_cast<signed_tick_t>(now - nextStartTime) < 0) {
+            yield_impl();
+            now = m_getCurrentTimeFunc();
+        }
+    }
+
+    const eerratic_tick_t lateness = now - nextStartTime;
+    if (lateness > 0) {
+        m_latePeriodCount++;
+    }
+    // Late by less than a period: the loop starts on its boundary and its
+    // steps make up the lateness, so the phase is kept.
+    if (period == 0 || lateness < period) {
+        m_loopStartTime = nextStartTime;
+        beginLoop();
+        return ERROR_CODE_OK;
+    }
+
+    const eerratic_tick_t missedPeriods = lateness / period;
+    switch (m_overrunPolicy) {
+    case OverrunPolicy::Skip:
+        m_loopStartTime = nextStartTime + missedPeriods * period;
+        m_missedPeriodCount += missedPeriods;
+        break;
+    case OverrunPolicy::CatchUp:
+        // Each period is still run, this one after its own window closed
+        m_loopStartTime = nextStartTime;
+        m_missedPeriodCount++;
+        break;
+    case OverrunPolicy::PhaseReset:
+        m_loopStartTime = now;
+        m_missedPeriodCount += missedPeriods;
+        break;
+    }
+    beginLoop();
+    return ERROR_CODE_TOTAL_TIMEOUT;
+}
+
+uint64_t EEerraticTimer::getMissedPeriodCount() const {
+    return m_missedPeriodCount;
+}
+
+uint64_t EEerraticTimer::getLatePeriodCount() const {
+    return m_latePeriodCount;
+}
+
+void EEerraticTimer::enableSlack(eerratic_tick_t maxBorrow) {
+    m_slackEnabled = true;
+    m_maxBorrow = maxBorrow;
+    m_slack = 0;
+}
+
+void EEerraticTimer::disableSlack() {
+    m_slackEnabled = false;
+    m_slack = 0;
+}
+
+eerratic_tick_t EEerraticTimer::getSlack() const {
+    return m_slack;
+}
+
+// Only steps that end on an event can use extra time; a sleep would just sleep longer
+// The last step added sleeping the rest of the loop, as EERRATIC_LOOP_REMAINDER does in
+// EEerraticSchedule: it only fills the period, whatever its budget
+bool EEerraticTimer::isLoopRemainder(uint32_t slot) const {
+    const sleep_type_t sleepType = m_stepConfigs[slot].sleepType;
+    return slot + 1 == m_stepConfigs.size()
+        && (sleepType == SLEEP_REMAINING_TIME || sleepType == SLEEP_REMAINING_TIME_PRECISE);
+}
+
+eerratic_tick_t EEerraticTimer::grantSlack(const StepConfig& config) const {
+    if (!m_slackEnabled) {
+        return 0;
+    }
+    switch (config.sleepType) {
+    case WAIT_EVENT:
+    case WAIT_ANY_EVENT:
+    case WAIT_ALL_EVENTS:
+        return m_slack < m_maxBorrow ? m_slack : m_maxBorrow;
+    default:
+        return 0;
+    }
+}
+
+void EEerraticTimer::settleSlack(const StepConfig& config, StepRecorder& recorder, eerratic_tick_t elapsed) {
+    if (!m_slackEnabled) {
+        return;
+    }
+    if (elapsed < config.expectedElapsedTime) {
+        const eerratic_tick_t donated = config.expectedElapsedTime - elapsed;
+        m_slack += donated;
+        recorder.donatedSum += donated;
+    } else {
+        eerratic_tick_t borrowed = elapsed - config.expectedElapsedTime;
+        borrowed = borrowed < m_slack ? borrowed : m_slack;
+        m_slack -= borrowed;
+        recorder.borrowedSum += borrowed;
+    }
+}
+
+// Returns true, and records the skipped run, if the optional step in the slot must be
+// skipped; otherwise trims the budget to what the more critical steps after it leave over
+bool EEerraticTimer::shedStep(uint32_t slot, eerratic_tick_t now, eerratic_tick_t& budget) {
+    const uint8_t level = m_stepConfigs[slot].criticality;
+    // The loop remainder only takes what is left, so nothing is kept for it
+    eerratic_tick_t reserve = 0;
+    for (uint32_t later = slot + 1; later < m_stepConfigs.size(); later++) {
+        if (m_stepConfigs[later].criticality < level && !isLoopRemainder(later)) {
+            reserve += m_stepConfigs[later].expectedElapsedTime;
+        }
+    }
+    const eerratic_tick_t loopElapsed = now - m_loopStartTime;
+    const eerratic_tick_t remaining = loopElapsed < m_loopExpectedElapsedTime
+        ? m_loopExpectedElapsedTime - loopElapsed : 0;
+
+    StepRecorder& recorder = m_stepStats[slot];
+    if (remaining <= reserve) {
+        recorder.shedCount++;
+        m_timerUtils.elapsed_time = 0;
+        if (m_traceBuffer) {
+            m_traceBuffer->push({ now, now, m_stepIds[slot], ERROR_CODE_SHED, m_traceLoopId });
+        }
+        return true;
+    }
+    if (remaining - reserve < budget) {
+        budget = remaining - reserve;
+        recorder.shortenedCount++;
+    }
+    return false;
 }
 
 ERROR_CODE EEerraticTimer::executeSleep(int id) {
-    auto it = m_steps.find(id);
-    if (it == m_steps.end()) {
+    uint32_t slot = findStep(id);
+    if (slot == kNoStep) {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+    return executeSleep(StepHandle{ slot });
+}
+
+ERROR_CODE EEerraticTimer::executeSleep(StepHandle handle) {
+    if (handle.index >= m_stepConfigs.size()) {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+    const StepConfig& config = m_stepConfigs[handle.index];
+    bindStep(handle.index, m_timerUtils);
+    m_timerUtils.expected_elapsed_time += grantSlack(config);
+    if (config.criticality > 0 && shedStep(handle.index, m_getCurrentTimeFunc(), m_timerUtils.expected_elapsed_time)) {
+        return ERROR_CODE_SHED;
+    }
+
+    const bool detectEvent = config.getEventTimeFunc
+        && (config.sleepType == WAIT_EVENT || config.sleepType == WAIT_TIME_AND_EVENT);
+    EventDetector detector{ m_timerUtils.is_event_set_func, m_timerUtils.event_ctx, &m_getCurrentTimeFunc, false, 0 };
+    if (detectEvent && detector.isEventSetFunc != nullptr) {
+        m_timerUtils.is_event_set_func = EventDetector::isEventSet;
+        m_timerUtils.event_ctx = &detector;
+    }
+
+    const eerratic_tick_t beginTime = (m_traceBuffer || detectEvent || m_watchdog.channel) ? m_getCurrentTimeFunc() : 0;
+    if (m_watchdog.channel) {
+        m_watchdog.channel->beginStep(m_stepIds[handle.index], beginTime + m_timerUtils.expected_elapsed_time);
+    }
+    ERROR_CODE result = eerratic_sleep_ctx(m_loopStartTime, m_loopExpectedElapsedTime, &m_timerUtils, config.sleepType);
+    finishStep(handle.index, result, beginTime, detectEvent ? &detector : nullptr);
+    return result;
+}
+
+ERROR_CODE EEerraticTimer::beginStep(StepHandle handle) {
+    if (handle.index >= m_stepConfigs.size()) {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+    const StepConfig& config = m_stepConfigs[handle.index];
+    if (config.sleepType == WAIT_ANY_EVENT || config.sleepType == WAIT_ALL_EVENTS) {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+    bindStep(handle.index, m_timerUtils);
+
+    m_pollDetectEvent = config.getEventTimeFunc
+        && (config.sleepType == WAIT_EVENT || config.sleepType == WAIT_TIME_AND_EVENT);
+    m_pollDetector = EventDetector{ m_timerUtils.is_event_set_func, m_timerUtils.event_ctx, &m_getCurrentTimeFunc, false, 0 };
+    if (m_pollDetectEvent && m_pollDetector.isEventSetFunc != nullptr) {
+        m_timerUtils.is_event_set_func = EventDetector::isEventSet;
+        m_timerUtils.event_ctx = &m_pollDetector;
+    }
+
+    const eerratic_tick_t now = m_getCurrentTimeFunc();
+    eerratic_tick_t budget = config.expectedElapsedTime + grantSlack(config);
+    if (config.criticality > 0 && shedStep(handle.index, now, budget)) {
+        return ERROR_CODE_SHED;
+    }
+    m_pollSlot = handle.index;
+    m_pollBeginTime = now;
+    step_poll_begin(&m_poll, budget, config.sleepType, m_pollBeginTime);
+    if (m_watchdog.channel) {
+        m_watchdog.channel->beginStep(m_stepIds[handle.index], m_pollBeginTime + m_poll.expected_elapsed_time);
+    }
+    return ERROR_CODE_OK;
+}
+
+ERROR_CODE EEerraticTimer::pollStep(eerratic_tick_t currentTime, eerratic_tick_t& wakeTime) {
+    if (m_pollSlot == kNoStep) {
         return ERROR_CODE_INVALID_PARAMETER;
     }
-    m_timerUtils.expected_elapsed_time = it->second.expectedElapsedTime;
-    m_timerUtils.is_event_set_func = it->second.isEventSetFunc;
-    return eerratic_sleep(m_loopStartTime, m_loopExpectedElapsedTime, &m_timerUtils, it->second.sleepType);
+    ERROR_CODE result = step_poll(&m_poll, m_loopStartTime, m_loopExpectedElapsedTime, currentTime, &m_timerUtils, &wakeTime);
+    if (result == ERROR_CODE_PENDING) {
+        return result;
+    }
+    const uint32_t slot = m_pollSlot;
+    m_pollSlot = kNoStep;
+    m_timerUtils.elapsed_time = m_poll.elapsed_time;
+    finishStep(slot, result, m_pollBeginTime, m_pollDetectEvent ? &m_pollDetector : nullptr);
+    return result;
+}
+
+bool EEerraticTimer::isPollingEvent() const {
+    return m_pollSlot != kNoStep && !m_poll.event_seen
+        && (m_poll.sleep_type == WAIT_EVENT || m_poll.sleep_type == WAIT_TIME_AND_EVENT);
 }
 
-uint32_t EEerraticTimer::getLastElapsedTime() const {
+// Statistics, event timing, trace and metrics of a step that just ended
+void EEerraticTimer::finishStep(uint32_t slot, ERROR_CODE result, eerratic_tick_t beginTime, const EventDetector* detector) {
+    const StepConfig& config = m_stepConfigs[slot];
+    StepRecorder& recorder = m_stepStats[slot];
+    if (result == ERROR_CODE_OK || result == ERROR_CODE_TIMEOUT) {
+        recorder.record(m_timerUtils.elapsed_time, result);
+        settleSlack(config, recorder, m_timerUtils.elapsed_time);
+        autoTune(slot);
+    }
+    if (isLoopRemainder(slot)) {
+        m_loopRemainderTime += m_timerUtils.elapsed_time;
+    }
+    if (detector != nullptr) {
+        recorder.lastEventTiming = EventTiming{ false, 0, 0 };
+        eerratic_tick_t firedTime = 0;
+        if (detector->detected && config.getEventTimeFunc(firedTime)) {
+            // An event that fired before the step started is only waited on from the start
+            const eerratic_tick_t waitFrom = (firedTime - beginTime) <= (detector->detectedTime - beginTime) ? firedTime : beginTime;
+            recorder.lastEventTiming = EventTiming{ true, firedTime, detector->detectedTime };
+            recorder.eventLatency.record(detector->detectedTime - waitFrom);
+        }
+    }
+    const eerratic_tick_t endTime = (m_traceBuffer || m_watchdog.channel) ? m_getCurrentTimeFunc() : 0;
+    if (m_watchdog.channel) {
+        m_watchdog.channel->endStep(endTime);
+    }
+    if (m_traceBuffer) {
+        m_traceBuffer->push({ beginTime, endTime, m_stepIds[slot],
+                              static_cast<int32_t>(result), m_traceLoopId });
+    }
+    if (m_metricsExporter) {
+        m_metricsExporter->recordStep(slot, m_stepIds[slot], m_timerUtils.elapsed_time, result);
+    }
+}
+
+void EEerraticTimer::addGroup(int groupId, std::initializer_list<int> stepIds) {
+    if (stepIds.size() == 0) {
+        throw std::invalid_argument("group has no steps");
+    }
+
+    Group group{};
+    group.id = groupId;
+    for (int stepId : stepIds) {
+        uint32_t slot = findStep(stepId);
+        if (slot == kNoStep) {
+            throw std::invalid_argument("group step is not added");
+        }
+        if (std::find(group.slots.begin(), group.slots.end(), slot) != group.slots.end()) {
+            throw std::invalid_argument("group step is listed twice");
+        }
+        group.slots.push_back(slot);
+    }
+    group.results.resize(group.slots.size(), ERROR_CODE_OK);
+    group.beginTimes.resize(group.slots.size(), 0);
+    group.endTimes.resize(group.slots.size(), 0);
+    group.elapsedTimes.resize(group.slots.size(), 0);
+
+    Group* existing = findGroup(groupId);
+    if (existing != nullptr) {
+        *existing = std::move(group);
+    } else {
+        m_groups.push_back(std::move(group));
+    }
+}
+
+ERROR_CODE EEerraticTimer::executeGroup(int groupId) {
+    Group* group = findGroup(groupId);
+    if (group == nullptr) {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+
+    const eerratic_tick_t beginTime = m_getCurrentTimeFunc();
+    if (m_watchdog.channel) {
+        // Watched as a whole, under the group id, until its slowest member's deadline
+        eerratic_tick_t budget = 0;
+        for (uint32_t slot : group->slots) {
+            budget = std::max(budget, m_stepConfigs[slot].expectedElapsedTime);
+        }
+        m_watchdog.channel->beginStep(groupId, beginTime + budget);
+    }
+    if (group->slots.size() == 1) {
+        runGroupMember(*group, 0);
+    } else {
+        if (!m_groupWorkers) {
+            m_groupWorkers.reset(new GroupWorkers());
+        }
+        m_groupWorkers->reserve(group->slots.size() - 1);
+        m_groupWorkers->run(this, group);
+    }
+    const eerratic_tick_t endTime = m_getCurrentTimeFunc();
+    m_timerUtils.elapsed_time = endTime - beginTime;
+    if (m_watchdog.channel) {
+        m_watchdog.channel->endStep(endTime);
+    }
+
+    // Statistics and the trace buffer have a single writer, so members report here
+    ERROR_CODE combined = ERROR_CODE_OK;
+    for (size_t member = 0; member < group->slots.size(); member++) {
+        const uint32_t slot = group->slots[member];
+        const ERROR_CODE result = group->results[member];
+        if (result == ERROR_CODE_OK || result == ERROR_CODE_TIMEOUT) {
+            m_stepStats[slot].record(group->elapsedTimes[member], result);
+            autoTune(slot);
+        }
+        if (m_traceBuffer) {
+            m_traceBuffer->push({ group->beginTimes[member], group->endTimes[member], m_stepIds[slot],
+                                  static_cast<int32_t>(result), m_traceLoopId });
+        }
+        if (m_metricsExporter) {
+            m_metricsExporter->recordStep(slot, m_stepIds[slot], group->elapsedTimes[member], result);
+        }
+        if (resultRank(result) < resultRank(combined)) {
+            combined = result;
+        }
+    }
+    return combined;
+}
+
+const std::vector<eerratic_tick_t>* EEerraticTimer::getGroupElapsedTimes(int groupId) const {
+    for (const Group& group : m_groups) {
+        if (group.id == groupId) {
+            return &group.elapsedTimes;
+        }
+    }
+    return nullptr;
+}
+
+EEerraticTimer::Group* EEerraticTimer::findGroup(int groupId) {
+    for (Group& group : m_groups) {
+        if (group.id == groupId) {
+            return &group;
+        }
+    }
+    return nullptr;
+}
+
+// Runs on any thread: only the member's own slot state and group entry are written
+void EEerraticTimer::runGroupMember(Group& group, size_t member) {
+    const uint32_t slot = group.slots[member];
+    timer_utils_ctx_t timerUtils{};
+    bindStep(slot, timerUtils);
+    group.beginTimes[member] = m_getCurrentTimeFunc();
+    group.results[member] = eerratic_sleep_ctx(m_loopStartTime, m_loopExpectedElapsedTime, &timerUtils, m_stepConfigs[slot].sleepType);
+    group.endTimes[member] = m_getCurrentTimeFunc();
+    group.elapsedTimes[member] = timerUtils.elapsed_time;
+}
+
+// The contexts point into this object and the step table, so they are
+// rebound on every call instead of once at construction.
+void EEerraticTimer::bindStep(uint32_t slot, timer_utils_ctx_t& timerUtils) {
+    const StepConfig& config = m_stepConfigs[slot];
+    timerUtils.expected_elapsed_time = config.expectedElapsedTime;
+    timerUtils.get_current_time_func = m_getCurrentTimeFunc.invoker();
+    timerUtils.time_ctx = m_getCurrentTimeFunc.target();
+    timerUtils.sleep_func = m_sleepFunc.invoker();
+    timerUtils.sleep_ctx = m_sleepFunc.target();
+    timerUtils.is_event_set_func = config.isEventSetFunc.invoker();
+    timerUtils.event_ctx = config.isEventSetFunc.target();
+    timerUtils.wait_backend.policy = config.waitPolicy;
+    timerUtils.wait_backend.yield_func = yield_impl;
+    timerUtils.wait_backend.wait_event_func = config.waitEventFunc.invoker();
+    timerUtils.wait_backend.wait_event_ctx = config.waitEventFunc.target();
+    timerUtils.precise_sleep = &m_preciseSleeps[slot];
+    timerUtils.get_event_mask_func = config.getEventMaskFunc.invoker();
+    timerUtils.event_mask_ctx = config.getEventMaskFunc.target();
+    timerUtils.event_set = &m_eventSets[slot];
+}
+
+eerratic_tick_t EEerraticTimer::getLastElapsedTime() const {
     return m_timerUtils.elapsed_time;
 }
 
-uint32_t EEerraticTimer::getLoopStartTime() const {
+eerratic_tick_t EEerraticTimer::getLoopStartTime() const {
     return m_loopStartTime;
 }
+
+ERROR_CODE EEerraticTimer::getStepStats(int id, StepStats& stats) const {
+    uint32_t slot = findStep(id);
+    if (slot == kNoStep) {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+    const StepRecorder& recorder = m_stepStats[slot];
+    const EEerraticHistogram& histogram = recorder.histogram;
+    const uint64_t count = histogram.getTotalCount();
+
+    stats.count = count;
+    stats.overrunCount = recorder.overrunCount;
+    stats.min = histogram.getMin();
+    stats.max = histogram.getMax();
+    stats.mean = count ? static_cast<double>(recorder.elapsedSum) / static_cast<double>(count) : 0.0;
+    stats.p50 = histogram.getValueAtPercentile(50.0);
+    stats.p90 = histogram.getValueAtPercentile(90.0);
+    stats.p99 = histogram.getValueAtPercentile(99.0);
+    stats.p999 = histogram.getValueAtPercentile(99.9);
+    stats.meanJitter = count > 1 ? static_cast<double>(recorder.jitterSum) / static_cast<double>(count - 1) : 0.0;
+    stats.maxJitter = recorder.maxJitter;
+    stats.borrowedTime = recorder.borrowedSum;
+    stats.donatedTime = recorder.donatedSum;
+    stats.eventLatencyCount = recorder.eventLatency.getTotalCount();
+    stats.eventLatencyP50 = recorder.eventLatency.getValueAtPercentile(50.0);
+    stats.eventLatencyP99 = recorder.eventLatency.getValueAtPercentile(99.0);
+    stats.eventLatencyMax = recorder.eventLatency.getMax();
+    stats.shedCount = recorder.shedCount;
+    stats.shortenedCount = recorder.shortenedCount;
+    return ERROR_CODE_OK;
+}
+
+const EEerraticHistogram* EEerraticTimer::getStepHistogram(int id) const {
+    uint32_t slot = findStep(id);
+    if (slot == kNoStep) {
+        return nullptr;
+    }
+    return &m_stepStats[slot].histogram;
+}
+
+bool EEerraticTimer::EventDetector::isEventSet(void* ctx) {
+    EventDetector* detector = static_cast<EventDetector*>(ctx);
+    if (!detector->isEventSetFunc(detector->eventCtx)) {
+        return false;
+    }
+    if (!detector->detected) {
+        detector->detected = true;
+        detector->detectedTime = (*detector->getCurrentTimeFunc)();
+    }
+    return true;
+}
+
+ERROR_CODE EEerraticTimer::setEventTimeFunc(int id, EventTimeFunction getEventTimeFunc) {
+    uint32_t slot = findStep(id);
+    if (slot == kNoStep) {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+    m_stepConfigs[slot].getEventTimeFunc = getEventTimeFunc;
+    return ERROR_CODE_OK;
+}
+
+ERROR_CODE EEerraticTimer::setStepCriticality(int id, uint8_t level) {
+    uint32_t slot = findStep(id);
+    if (slot == kNoStep) {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+    m_stepConfigs[slot].criticality = level;
+    return ERROR_CODE_OK;
+}
+
+ERROR_CODE EEerraticTimer::getLastEventTiming(int id, EventTiming& timing) const {
+    uint32_t slot = findStep(id);
+    if (slot == kNoStep) {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+    timing = m_stepStats[slot].lastEventTiming;
+    return ERROR_CODE_OK;
+}
+
+const EEerraticHistogram* EEerraticTimer::getEventLatencyHistogram(int id) const {
+    uint32_t slot = findStep(id);
+    if (slot == kNoStep) {
+        return nullptr;
+    }
+    return &m_stepStats[slot].eventLatency;
+}
+
+ERROR_CODE EEerraticTimer::getPreciseSleepState(int id, precise_sleep_t& state) const {
+    uint32_t slot = findStep(id);
+    if (slot == kNoStep) {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+    state = m_preciseSleeps[slot];
+    return ERROR_CODE_OK;
+}
+
+ERROR_CODE EEerraticTimer::getEventSet(int id, event_set_t& eventSet) const {
+    uint32_t slot = findStep(id);
+    if (slot == kNoStep) {
+        return ERROR_CODE_INVALID_PARAMETER;
+    }
+    eventSet = m_eventSets[slot];
+    return ERROR_CODE_OK;
+}
+
+void EEerraticTimer::setTraceBuffer(EEerraticTraceBuffer* buffer, uint32_t loopId) {
+    m_traceBuffer = buffer;
+    m_traceLoopId = loopId;
+}
+
+void EEerraticTimer::setMetricsExporter(EEerraticMetricsExporter* exporter) {
+    m_metricsExporter = exporter;
+}
+
+void EEerraticTimer::setWatchdog(EEerraticWatchdog* watchdog, uint32_t channelId) {
+    m_watchdog = WatchdogLink(watchdog, channelId);
+    if (m_watchdog.channel && m_loopActive) {
+        beginLoop();
+    }
+}
+
+void EEerraticTimer::resetStats() {
+    for (StepRecorder& recorder : m_stepStats) {
+        recorder.reset();
+    }
+    m_loopHistogram.reset();
+    // The learned margins stay, only the reported deadline errors restart
+    for (precise_sleep_t& preciseSleep : m_preciseSleeps) {
+        preciseSleep.last_error = 0;
+        preciseSleep.max_error = 0;
+        preciseSleep.count = 0;
+    }
+}
+
+bool EEerraticTimer::proposeBudget(uint32_t slot, const AutoTuneConfig& tuneConfig, BudgetProposal& proposal) const {
+    const StepConfig& config = m_stepConfigs[slot];
+    if (config.sleepType != WAIT_EVENT && config.sleepType != WAIT_ANY_EVENT && config.sleepType != WAIT_ALL_EVENTS) {
+        // Sleeps take their budget by design, and WAIT_TIME_AND_EVENT's budget is a minimum
+        return false;
+    }
+    const StepRecorder& recorder = m_stepStats[slot];
+    const uint64_t samples = recorder.tuning.getTotalCount();
+    if (samples == 0 || samples < tuneConfig.minSamples) {
+        return false;
+    }
+
+    proposal.id = m_stepIds[slot];
+    proposal.current = config.expectedElapsedTime;
+    proposal.samples = samples;
+    proposal.proposed = recorder.tuning.getValueAtPercentile(tuneConfig.percentile) + tuneConfig.margin;
+    // A timed-out run only says the step needed more than its budget
+    const double allowedTimeouts = static_cast<double>(samples) * (100.0 - tuneConfig.percentile) / 100.0;
+    proposal.censored = static_cast<double>(recorder.tuningTimeouts) > allowedTimeouts;
+    if (proposal.censored) {
+        const eerratic_tick_t doubled = proposal.current ? proposal.current * 2 : 1;
+        proposal.proposed = std::max(proposal.proposed, doubled);
+    }
+    proposal.capped = proposal.proposed > m_loopExpectedElapsedTime;
+    if (proposal.capped) {
+        proposal.proposed = m_loopExpectedElapsedTime;
+    }
+    return true;
+}
+
+void EEerraticTimer::setBudget(uint32_t slot, eerratic_tick_t budget) {
+    if (m_stepConfigs[slot].expectedElapsedTime == budget) {
+        return;
+    }
+    m_stepConfigs[slot].expectedElapsedTime = budget;
+    m_stepStats[slot].tuning.reset();
+    m_stepStats[slot].tuningTimeouts = 0;
+}
+
+std::vector<EEerraticTimer::BudgetProposal> EEerraticTimer::proposeBudgets(const AutoTuneConfig& tuneConfig) const {
+    std::vector<BudgetProposal> proposals;
+    BudgetProposal proposal{};
+    for (uint32_t slot = 0; slot < m_stepConfigs.size(); slot++) {
+        if (proposeBudget(slot, tuneConfig, proposal)) {
+            proposals.push_back(proposal);
+        }
+    }
+    return proposals;
+}
+
+size_t EEerraticTimer::applyBudgets(const AutoTuneConfig& tuneConfig) {
+    size_t changed = 0;
+    BudgetProposal proposal{};
+    for (uint32_t slot = 0; slot < m_stepConfigs.size(); slot++) {
+        if (proposeBudget(slot, tuneConfig, proposal) && proposal.proposed != proposal.current) {
+            setBudget(slot, proposal.proposed);
+            changed++;
+        }
+    }
+    return changed;
+}
+
+void EEerraticTimer::enableAutoTune(const AutoTuneConfig& tuneConfig) {
+    m_autoTune = tuneConfig;
+    m_autoTuneEnabled = true;
+}
+
+void EEerraticTimer::disableAutoTune() {
+    m_autoTuneEnabled = false;
+}
+
+void EEerraticTimer::autoTune(uint32_t slot) {
+    if (!m_autoTuneEnabled) {
+        return;
+    }
+    const uint64_t samples = m_stepStats[slot].tuning.getTotalCount();
+    if (samples % std::max<uint64_t>(m_autoTune.minSamples, 1) != 0) {
+        return;
+    }
+    BudgetProposal proposal{};
+    if (proposeBudget(slot, m_autoTune, proposal)) {
+        setBudget(slot, proposal.proposed);
+    }
+}
+
+EEerraticTimer::FeasibilityReport EEerraticTimer::getFeasibilityReport() const {
+    FeasibilityReport report{};
+    report.period = m_loopExpectedElapsedTime;
+
+    // A group member stands for the whole group, which counts as its slowest member
+    std::vector<bool> counted(m_stepConfigs.size(), false);
+    for (uint32_t slot = 0; slot < m_stepConfigs.size(); slot++) {
+        if (counted[slot] || isLoopRemainder(slot)) {
+            continue;
+        }
+        std::vector<uint32_t> members{ slot };
+        for (const Group& group : m_groups) {
+            if (std::find(group.slots.begin(), group.slots.end(), slot) != group.slots.end()) {
+                members = group.slots;
+                break;
+            }
+        }
+
+        eerratic_tick_t budget = 0;
+        eerratic_tick_t mean = 0;
+        eerratic_tick_t worst = 0;
+        uint32_t worstSlot = slot;
+        for (uint32_t member : members) {
+            counted[member] = true;
+            if (isLoopRemainder(member)) {
+                continue;
+            }
+            const StepRecorder& recorder = m_stepStats[member];
+            const uint64_t count = recorder.histogram.getTotalCount();
+            budget = std::max(budget, m_stepConfigs[member].expectedElapsedTime);
+            mean = std::max(mean, count ? static_cast<eerratic_tick_t>(recorder.elapsedSum / count) : 0);
+            if (recorder.histogram.getMax() > worst) {
+                worst = recorder.histogram.getMax();
+                worstSlot = member;
+            }
+        }
+        report.budgetPath += budget;
+        report.meanPath += mean;
+        report.worstPath += worst;
+        report.criticalPath.push_back(m_stepIds[worstSlot]);
+    }
+
+    report.loopCount = m_loopHistogram.getTotalCount();
+    report.loopP99 = m_loopHistogram.getValueAtPercentile(99.0);
+    report.loopMax = m_loopHistogram.getMax();
+    const int64_t period = static_cast<int64_t>(report.period);
+    report.budgetHeadroom = period - static_cast<int64_t>(report.budgetPath);
+    report.worstHeadroom = period - static_cast<int64_t>(report.worstPath);
+    report.loopHeadroom = period - static_cast<int64_t>(report.loopP99);
+    return report;
+}
+
+bool EEerraticTimer::FeasibilityReport::fits() const {
+    return budgetHeadroom >= 0 && worstHeadroom >= 0 && loopHeadroom >= 0;
+}
+
+std::string EEerraticTimer::FeasibilityReport::describe() const {
+    std::string out;
+    out += "period: " + std::to_string(period) + "\n";
+    out += "budget path: " + std::to_string(budgetPath) + " (headroom " + std::to_string(budgetHeadroom) + ")\n";
+    out += "worst path: " + std::to_string(worstPath) + " (headroom " + std::to_string(worstHeadroom) + ") steps";
+    for (int id : criticalPath) {
+        out += " " + std::to_string(id);
+    }
+    out += "\n";
+    out += "mean path: " + std::to_string(meanPath) + "\n";
+    out += "loops: " + std::to_string(loopCount) + " p99 " + std::to_string(loopP99) + " max " + std::to_string(loopMax)
+         + " (headroom " + std::to_string(loopHeadroom) + ")\n";
+    out += fits() ? "fits\n" : "does not fit\n";
+    return out;
+}
+
+const EEerraticHistogram& EEerraticTimer::getLoopHistogram() const {
+    return m_loopHistogram;
+}
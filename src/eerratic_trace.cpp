@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "eerratic_trace.hpp"
+
+#include <chrono>
+
+
+namespace {
+
+const size_t kDrainChunk = 256;
+
+const char* errorCodeName(int32_t result) {
+    switch (result) {
+    case ERROR_CODE_OK: return "OK";
+    case ERROR_CODE_PENDING: return "PENDING";
+    case ERROR_CODE_SHED: return "SHED";
+    case ERROR_CODE_TIMEOUT: return "TIMEOUT";
+    case ERROR_CODE_NULL_POINTER: return "NULL_POINTER";
+    case ERROR_CODE_TOTAL_TIMEOUT: return "TOTAL_TIMEOUT";
+    case ERROR_CODE_INVALID_PARAMETER: return "INVALID_PARAMETER";
+    default: return "UNKNOWN";
+    }
+}
+
+const char* categoryName(int32_t result) {
+    switch (result) {
+    case ERROR_CODE_OK: return "step";
+    case ERROR_CODE_SHED: return "shed";
+    default: return "overrun";
+    }
+}
+
+// Chrome trace timestamps are microseconds. They are written from integers, so a
+// clock with days of uptime keeps its full resolution; finer time bases get a
+// fixed fraction (3 digits for nanoseconds).
+void writeMicroseconds(std::ostream& stream, eerratic_tick_t ticks) {
+    const uint64_t value = static_cast<uint64_t>(ticks);
+#if EERRATIC_TICKS_PER_SEC <= 1000000u
+    stream << value * (1000000u / EERRATIC_TICKS_PER_SEC);
+#else
+    const uint64_t ticksPerUs = EERRATIC_TICKS_PER_SEC / 1000000u;
+    stream << value / ticksPerUs << '.';
+    const uint64_t fraction = value % ticksPerUs;
+    for (uint64_t scale = ticksPerUs / 10; scale > 0; scale /= 10) {
+        stream << static_cast<char>('0' + (fraction / scale) % 10);
+    }
+#endif
+}
+
+} // namespace
+
+
+void writeChromeTraceBegin(std::ostream& stream) {
+    stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+}
+
+void writeChromeTraceRecords(std::ostream& stream, const EEerraticTraceRecord* records, size_t count, bool& first) {
+    for (size_t i = 0; i < count; i++) {
+        const EEerraticTraceRecord& record = records[i];
+        stream << (first ? "\n" : ",\n");
+        first = false;
+        stream << "{\"name\":\"step " << record.stepId << "\""
+               << ",\"cat\":\"" << categoryName(record.result) << "\""
+               << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << record.loopId
+               << ",\"ts\":";
+        writeMicroseconds(stream, record.beginTime);
+        stream << ",\"dur\":";
+        writeMicroseconds(stream, record.endTime - record.beginTime);
+        stream << ",\"args\":{\"result\":\"" << errorCodeName(record.result) << "\"}}";
+    }
+}
+
+void writeChromeTraceEnd(std::ostream& stream) {
+    stream << "\n]}\n";
+}
+
+size_t exportChromeTrace(EEerraticTraceBuffer& buffer, std::ostream& stream) {
+    EEerraticTraceRecord chunk[kDrainChunk];
+    size_t total = 0;
+    bool first = true;
+
+    writeChromeTraceBegin(stream);
+    size_t count;
+    while ((count = buffer.drain(chunk, kDrainChunk)) > 0) {
+        writeChromeTraceRecords(stream, chunk, count, first);
+        total += count;
+    }
+    writeChromeTraceEnd(stream);
+    return total;
+}
+
+
+EEerraticTraceWriter::EEerraticTraceWriter(EEerraticTraceBuffer& buffer, std::ostream& stream, uint32_t drainIntervalMs)
+    : m_buffer(buffer), m_stream(stream), m_drainIntervalMs(drainIntervalMs ? drainIntervalMs : 1)
+{
+}
+
+EEerraticTraceWriter::~EEerraticTraceWriter() {
+    stop();
+}
+
+void EEerraticTraceWriter::start() {
+    if (m_running.exchange(true)) {
+        return;
+    }
+    m_first = true;
+    writeChromeTraceBegin(m_stream);
+    m_thread = std::thread([this] {
+        while (m_running.load(std::memory_order_relaxed)) {
+            drainOnce();
+            std::this_thread::sleep_for(std::chrono::milliseconds(m_drainIntervalMs));
+        }
+    });
+}
+
+void EEerraticTraceWriter::stop() {
+    if (!m_running.exchange(false)) {
+        return;
+    }
+    m_thread.join();
+    drainOnce();
+    writeChromeTraceEnd(m_stream);
+    m_stream.flush();
+}
+
+uint64_t EEerraticTraceWriter::getWrittenCount() const {
+    return m_written.load(std::memory_order_relaxed);
+}
+
+void EEerraticTraceWriter::drainOnce() {
+    EEerraticTraceRecord chunk[kDrainChunk];
+    size_t count;
+    while ((count = m_buffer.drain(chunk, kDrainChunk)) > 0) {
+        writeChromeTraceRecords(m_stream, chunk, count, m_first);
+        m_written.fetch_add(count, std::memory_order_relaxed);
+    }
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "eerratic_watchdog.hpp"
+
+#include <chrono>
+#include <type_traits>
+
+
+namespace {
+
+using tick_duration_t = std::chrono::duration<int64_t, std::ratio<1, EERRATIC_TICKS_PER_SEC>>;
+using signed_tick_t = std::make_signed_t<eerratic_tick_t>;
+
+} // namespace
+
+
+void EEerraticWatchdog::Channel::Deadline::arm(int stepId, eerratic_tick_t time) {
+    seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    id.store(stepId, std::memory_order_relaxed);
+    deadline.store(time, std::memory_order_relaxed);
+    armed.store(true, std::memory_order_relaxed);
+    seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+eerratic_tick_t EEerraticWatchdog::Channel::Deadline::disarm(eerratic_tick_t now) {
+    if (!armed.load(std::memory_order_relaxed)) {
+        return 0;
+    }
+    const eerratic_tick_t time = deadline.load(std::memory_order_relaxed);
+    clear();
+    return static_cast<signed_tick_t>(now - time) > 0 ? now - time : 0;
+}
+
+void EEerraticWatchdog::Channel::Deadline::clear() {
+    seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    armed.store(false, std::memory_order_relaxed);
+    seq.store(seq.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void EEerraticWatchdog::Channel::recordOverrun(eerratic_tick_t overrun,
+            std::atomic<uint64_t>& count, std::atomic<eerratic_tick_t>& maximum) {
+    if (overrun <= m_tolerance) {
+        return;
+    }
+    count.store(count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (overrun > maximum.load(std::memory_order_relaxed)) {
+        maximum.store(overrun, std::memory_order_relaxed);
+    }
+}
+
+void EEerraticWatchdog::Channel::endStep(eerratic_tick_t now) {
+    recordOverrun(m_step.disarm(now), m_stepOverruns, m_maxStepOverrun);
+}
+
+void EEerraticWatchdog::Channel::endLoop(eerratic_tick_t now) {
+    recordOverrun(m_loop.disarm(now), m_loopOverruns, m_maxLoopOverrun);
+}
+
+EEerraticWatchdog::ChannelStats EEerraticWatchdog::Channel::getStats() const {
+    return ChannelStats{
+        m_stepMisses.load(std::memory_order_relaxed),
+        m_loopMisses.load(std::memory_order_relaxed),
+        m_stepOverruns.load(std::memory_order_relaxed),
+        m_loopOverruns.load(std::memory_order_relaxed),
+        m_maxStepOverrun.load(std::memory_order_relaxed),
+        m_maxLoopOverrun.load(std::memory_order_relaxed),
+    };
+}
+
+EEerraticWatchdog::EEerraticWatchdog(TimeFunction getTimeFunc,
+            eerratic_tick_t checkInterval,
+            eerratic_tick_t tolerance)
+    : m_getCurrentTimeFunc(getTimeFunc),
+      m_checkInterval(checkInterval ? checkInterval : 1),
+      m_tolerance(tolerance)
+{
+    if (!m_getCurrentTimeFunc) {
+        throw std::invalid_argument("get_current_time_func is null");
+    }
+}
+
+EEerraticWatchdog::~EEerraticWatchdog() {
+    stop();
+}
+
+void EEerraticWatchdog::addHandler(MissHandler handler) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        throw std::logic_error("handlers must be added before start()");
+    }
+    if (!handler) {
+        throw std::invalid_argument("miss handler is null");
+    }
+    m_handlers.push_back(handler);
+}
+
+EEerraticWatchdog::Channel& EEerraticWatchdog::addChannel(uint32_t id) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_channels.emplace_back(new Channel(id, m_tolerance));
+    return *m_channels.back();
+}
+
+void EEerraticWatchdog::removeChannel(Channel& channel) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto it = m_channels.begin(); it != m_channels.end(); ++it) {
+        if (it->get() == &channel) {
+            m_channels.erase(it);
+            return;
+        }
+    }
+    throw std::invalid_argument("channel does not belong to this watchdog");
+}
+
+size_t EEerraticWatchdog::getChannelCount() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_channels.size();
+}
+
+void EEerraticWatchdog::start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) {
+        return;
+    }
+    m_running = true;
+    m_monitor = std::thread([this] { monitorMain(); });
+}
+
+void EEerraticWatchdog::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) {
+            return;
+        }
+        m_running = false;
+    }
+    m_cv.notify_all();
+    m_monitor.join();
+}
+
+void EEerraticWatchdog::monitorMain() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        m_cv.wait_for(lock, tick_duration_t(static_cast<int64_t>(m_checkInterval)));
+        if (!m_running) {
+            break;
+        }
+        const eerratic_tick_t now = m_getCurrentTimeFunc();
+        for (const std::unique_ptr<Channel>& channel : m_channels) {
+            check(*channel, now);
+        }
+        if (m_misses.empty()) {
+            continue;
+        }
+
+        // Handlers run unlocked, so a slow handler does not hold up addChannel()
+        std::vector<Miss> misses;
+        misses.swap(m_misses);
+        lock.unlock();
+        for (const Miss& miss : misses) {
+            for (const MissHandler& handler : m_handlers) {
+                handler(miss);
+            }
+        }
+        lock.lock();
+        misses.clear();
+        m_misses.swap(misses);
+    }
+}
+
+void EEerraticWatchdog::check(Channel& channel, eerratic_tick_t now) {
+    int id = 0;
+    eerratic_tick_t deadline = 0;
+    if (checkDeadline(channel.m_step, now, id, deadline)) {
+        channel.m_stepMisses.fetch_add(1, std::memory_order_relaxed);
+        m_misses.push_back({ channel.m_id, id, MissKind::Step, deadline, now, now - deadline });
+    }
+    if (checkDeadline(channel.m_loop, now, id, deadline)) {
+        channel.m_loopMisses.fetch_add(1, std::memory_order_relaxed);
+        m_misses.push_back({ channel.m_id, -1, MissKind::Loop, deadline, now, now - deadline });
+    }
+}
+
+// True once per armed deadline that is more than tolerance behind now. A
+// deadline that changes while it is read is looked at again on the next check.
+bool EEerraticWatchdog::checkDeadline(Channel::Deadline& published, eerratic_tick_t now,
+            int& id, eerratic_tick_t& deadline) const {
+    const uint32_t seq = published.seq.load(std::memory_order_acquire);
+    if ((seq & 1u) || seq == published.reportedSeq) {
+        return false;
+    }
+    const bool armed = published.armed.load(std::memory_order_relaxed);
+    id = published.id.load(std::memory_order_relaxed);
+    deadline = published.deadline.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (published.seq.load(std::memory_order_relaxed) != seq || !armed) {
+        return false;
+    }
+    if (static_cast<signed_tick_t>(now - deadline) <= static_cast<signed_tick_t>(m_tolerance)) {
+        return false;
+    }
+    published.reportedSeq = seq;
+    return true;
+}
@@ -0,0 +1,34 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include "eerratic_clock.h"
+#include "eerratic_tsc_clock.hpp"
+
+#include <chrono>
+#include <thread>
+
+TEST(eerratic_clock, test_monotonic_time) {
+    eerratic_tick_t previous = eerratic_monotonic_time();
+    for (int i = 0; i < 1000; i++) {
+        const eerratic_tick_t now = eerratic_monotonic_time_ctx(nullptr);
+        EXPECT_LT(static_cast<int32_t>(now - previous), 1000);
+        EXPECT_GE(static_cast<int32_t>(now - previous), 0);
+        previous = now;
+    }
+}
+
+TEST(eerratic_clock, test_tsc_clock_tracks_monotonic_time) {
+    EEerraticTscClock clock(5);
+    const eerratic_tick_t tscStart = EEerraticTscClock::nowCtx(&clock);
+    const eerratic_tick_t monotonicStart = eerratic_monotonic_time();
+    EXPECT_NEAR(static_cast<int32_t>(monotonicStart - tscStart), 0, 2);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    const eerratic_tick_t tscElapsed = clock.now() - tscStart;
+    const eerratic_tick_t monotonicElapsed = eerratic_monotonic_time() - monotonicStart;
+    EXPECT_NEAR(static_cast<double>(tscElapsed), static_cast<double>(monotonicElapsed), 2.0);
+}
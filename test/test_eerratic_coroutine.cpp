@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include "eerratic_coroutine.hpp"
+#include "eerratic_timer_class.hpp"
+#include "eerratic_virtual_clock.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+struct LogEntry {
+    char loop;
+    int step;
+    ERROR_CODE result;
+    eerratic_tick_t time;
+};
+
+EEerraticTimer makeTimer(EEerraticVirtualClock& clock, eerratic_tick_t loopTime) {
+    return EEerraticTimer(loopTime,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+}
+
+EEerraticExecutor::Task loopA(EEerraticExecutor& executor, EEerraticTimer& timer,
+                              EEerraticVirtualClock& clock, std::vector<LogEntry>& log) {
+    for (int iteration = 0; iteration < 2; iteration++) {
+        timer.resetLoop();
+        for (int step = 0; step < 2; step++) {
+            ERROR_CODE result = co_await executor.step(timer, step);
+            log.push_back({ 'a', step, result, clock.now() });
+        }
+    }
+}
+
+EEerraticExecutor::Task loopB(EEerraticExecutor& executor, EEerraticTimer& timer,
+                              EEerraticVirtualClock& clock, std::vector<LogEntry>& log) {
+    for (int iteration = 0; iteration < 3; iteration++) {
+        timer.resetLoop();
+        ERROR_CODE result = co_await executor.step(timer, 0);
+        log.push_back({ 'b', 0, result, clock.now() });
+    }
+}
+
+} // namespace
+
+TEST(eerratic_coroutine, test_loops_interleave_on_one_thread) {
+    EEerraticVirtualClock clock(0, 0);
+    EEerraticVirtualClock::Event event(clock);
+    EEerraticExecutor executor([&clock] { return clock.now(); },
+                               [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); }, 5);
+
+    EEerraticTimer a = makeTimer(clock, 100);
+    a.addStep(0, 30, nullptr, SLEEP_REMAINING_TIME);
+    a.addStep(1, 50, [&event] { return event.isSet(); }, WAIT_EVENT);
+    EEerraticTimer b = makeTimer(clock, 100);
+    b.addStep(0, 20, nullptr, SLEEP_REMAINING_TIME);
+    event.setAt(42);
+    event.clearAt(50);
+
+    std::vector<LogEntry> log;
+    executor.spawn(loopA(executor, a, clock, log));
+    executor.spawn(loopB(executor, b, clock, log));
+    EXPECT_EQ(executor.getTaskCount(), 2u);
+    executor.run();
+    EXPECT_EQ(executor.getTaskCount(), 0u);
+
+    // The event is seen by the poll at 45; the second wait times out after its 50
+    const LogEntry expected[] = {
+        { 'b', 0, ERROR_CODE_OK, 20 },
+        { 'a', 0, ERROR_CODE_OK, 30 },
+        { 'b', 0, ERROR_CODE_OK, 40 },
+        { 'a', 1, ERROR_CODE_OK, 45 },
+        { 'b', 0, ERROR_CODE_OK, 60 },
+        { 'a', 0, ERROR_CODE_OK, 75 },
+        { 'a', 1, ERROR_CODE_TIMEOUT, 125 },
+    };
+    ASSERT_EQ(log.size(), std::size(expected));
+    for (size_t i = 0; i < log.size(); i++) {
+        EXPECT_EQ(log[i].loop, expected[i].loop) << i;
+        EXPECT_EQ(log[i].step, expected[i].step) << i;
+        EXPECT_EQ(log[i].result, expected[i].result) << i;
+        EXPECT_EQ(log[i].time, expected[i].time) << i;
+    }
+
+    EEerraticTimer::StepStats stats;
+    ASSERT_EQ(a.getStepStats(1, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.count, 2u);
+    EXPECT_EQ(stats.overrunCount, 1u);
+    EXPECT_EQ(stats.min, 15u);
+    EXPECT_EQ(a.getLastElapsedTime(), 50u);
+    ASSERT_EQ(b.getStepStats(0, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.count, 3u);
+}
+
+TEST(eerratic_coroutine, test_many_loops) {
+    const size_t loopCount = 500;
+    EEerraticVirtualClock clock(0, 0);
+    EEerraticExecutor executor([&clock] { return clock.now(); },
+                               [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+
+    std::vector<std::unique_ptr<EEerraticTimer>> timers;
+    size_t completed = 0;
+    auto loop = [](EEerraticExecutor& executor, EEerraticTimer& timer, size_t& completed) -> EEerraticExecutor::Task {
+        for (int iteration = 0; iteration < 10; iteration++) {
+            timer.resetLoop();
+            if (co_await executor.step(timer, 0) == ERROR_CODE_OK) {
+                completed++;
+            }
+        }
+    };
+    for (size_t i = 0; i < loopCount; i++) {
+        timers.push_back(std::make_unique<EEerraticTimer>(makeTimer(clock, 50)));
+        timers.back()->addStep(0, static_cast<eerratic_tick_t>(10 + i % 7), nullptr, SLEEP_REMAINING_TIME);
+        executor.spawn(loop(executor, *timers.back(), completed));
+    }
+    executor.run();
+    EXPECT_EQ(completed, loopCount * 10);
+    EXPECT_EQ(clock.now(), 160u);   // The slowest loops: 10 steps of 16
+}
+
+TEST(eerratic_coroutine, test_invalid_step_and_exception) {
+    EEerraticVirtualClock clock(0, 0);
+    EEerraticExecutor executor([&clock] { return clock.now(); },
+                               [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    EEerraticTimer timer = makeTimer(clock, 100);
+    timer.addStep(0, 10, nullptr, SLEEP_REMAINING_TIME);
+
+    ERROR_CODE result = ERROR_CODE_OK;
+    auto throwing = [](EEerraticExecutor& executor, EEerraticTimer& timer, ERROR_CODE& result) -> EEerraticExecutor::Task {
+        timer.resetLoop();
+        result = co_await executor.step(timer, 9);
+        co_await executor.step(timer, 0);
+        throw std::runtime_error("loop failed");
+    };
+    executor.spawn(throwing(executor, timer, result));
+    EXPECT_THROW(executor.run(), std::runtime_error);
+    EXPECT_EQ(result, ERROR_CODE_INVALID_PARAMETER);
+    EXPECT_EQ(clock.now(), 10u);
+    EXPECT_EQ(executor.getTaskCount(), 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
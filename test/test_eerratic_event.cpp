@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include "eerratic_event.hpp"
+#include "eerratic_timer_class.hpp"
+
+#include <chrono>
+#include <thread>
+
+// EEerraticEvent and parallel groups block on real threads, so these tests use
+// real time with generous bounds: a missed wake-up would show as the full timeout.
+static eerratic_tick_t get_steady_time_impl() {
+    return static_cast<eerratic_tick_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static void sleep_steady_impl(eerratic_tick_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+TEST(eerratic_event, test_set_and_clear) {
+    EEerraticEvent event;
+    EXPECT_FALSE(event.isSet());
+    EXPECT_FALSE(event.wait(0));
+
+    event.set();
+    EXPECT_TRUE(event.isSet());
+    EXPECT_TRUE(event.wait(5000));
+    EXPECT_TRUE(EEerraticEvent::isSetCtx(&event));
+
+    event.clear();
+    EXPECT_FALSE(event.isSet());
+}
+
+TEST(eerratic_event, test_wait_timeout) {
+    EEerraticEvent event;
+    const eerratic_tick_t start = get_steady_time_impl();
+    EXPECT_FALSE(event.wait(20));
+    EXPECT_GE(get_steady_time_impl() - start, 20u);
+}
+
+TEST(eerratic_event, test_wait_wakes_on_set) {
+    EEerraticEvent event;
+    std::thread producer([&event] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        event.set();
+    });
+    const eerratic_tick_t start = get_steady_time_impl();
+    EXPECT_TRUE(EEerraticEvent::waitCtx(&event, 5000));
+    EXPECT_LT(get_steady_time_impl() - start, 1000u);
+    producer.join();
+}
+
+TEST(eerratic_event, test_timer_event_step) {
+    EEerraticEvent event;
+    EEerraticTimer timer(10000, get_steady_time_impl, sleep_steady_impl);
+    timer.addStep(0, 5000, event, WAIT_EVENT);
+    EXPECT_THROW(timer.addStep(1, 5000, event, SLEEP_REMAINING_TIME), std::invalid_argument);
+
+    timer.resetLoop();
+    std::thread producer([&event] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        event.set();
+    });
+    EXPECT_EQ(timer.executeSleep(0), ERROR_CODE_OK);
+    EXPECT_LT(timer.getLastElapsedTime(), 1000u);
+    producer.join();
+}
+
+TEST(eerratic_event, test_fired_time) {
+    EEerraticEvent event;
+    eerratic_tick_t firedTime = 0;
+    EXPECT_FALSE(event.getFiredTime(firedTime));
+    event.set();
+    EXPECT_FALSE(event.getFiredTime(firedTime));
+    event.clear();
+
+    EEerraticTimer timer(10000, get_steady_time_impl, sleep_steady_impl);
+    timer.addStep(0, 5000, event, WAIT_EVENT);
+    timer.resetLoop();
+    std::thread producer([&event] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        event.set(get_steady_time_impl());
+    });
+    EXPECT_EQ(timer.executeSleep(0), ERROR_CODE_OK);
+    producer.join();
+
+    ASSERT_TRUE(event.getFiredTime(firedTime));
+    EEerraticTimer::EventTiming timing{};
+    ASSERT_EQ(timer.getLastEventTiming(0, timing), ERROR_CODE_OK);
+    EXPECT_TRUE(timing.valid);
+    EXPECT_EQ(timing.firedTime, firedTime);
+    EXPECT_LT(timing.detectedTime - timing.firedTime, 1000u);
+    EEerraticTimer::StepStats stats{};
+    ASSERT_EQ(timer.getStepStats(0, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.eventLatencyCount, 1u);
+}
+
+TEST(eerratic_event, test_parallel_group) {
+    EEerraticEvent ready;
+    EEerraticEvent never;
+    EEerraticTimer timer(10000, get_steady_time_impl, sleep_steady_impl);
+    // Step 0 only completes if step 1 runs at the same time and signals it
+    timer.addStep(0, 2000, ready, WAIT_EVENT);
+    timer.addStep(1, 2000, [&ready] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        ready.set();
+        return true;
+    }, WAIT_EVENT);
+    timer.addStep(2, 30, never, WAIT_EVENT);
+    timer.addGroup(0, { 0, 1 });
+    timer.addGroup(1, { 0, 1, 2 });
+    EXPECT_THROW(timer.addGroup(2, { 0, 5 }), std::invalid_argument);
+    EXPECT_EQ(timer.executeGroup(2), ERROR_CODE_INVALID_PARAMETER);
+
+    for (int i = 0; i < 3; i++) {
+        ready.clear();
+        timer.resetLoop();
+        EXPECT_EQ(timer.executeGroup(0), ERROR_CODE_OK);
+        EXPECT_LT(timer.getLastElapsedTime(), 1000u);
+    }
+
+    ready.clear();
+    timer.resetLoop();
+    EXPECT_EQ(timer.executeGroup(1), ERROR_CODE_TIMEOUT);
+    const std::vector<eerratic_tick_t>* elapsed = timer.getGroupElapsedTimes(1);
+    ASSERT_NE(elapsed, nullptr);
+    ASSERT_EQ(elapsed->size(), 3u);
+    EXPECT_LT((*elapsed)[0], 1000u);
+    EXPECT_GE((*elapsed)[2], 30u);
+
+    EEerraticTimer::StepStats stats{};
+    ASSERT_EQ(timer.getStepStats(2, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.count, 1u);
+    EXPECT_EQ(stats.overrunCount, 1u);
+}
@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include "eerratic_metrics.hpp"
+#include "eerratic_timer_class.hpp"
+#include "eerratic_virtual_clock.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+std::string metricsPath(const char* name) {
+    return ::testing::TempDir() + name + std::to_string(getpid());
+}
+
+} // namespace
+
+TEST(eerratic_metrics, test_timer_publishes_steps_and_loops) {
+    const std::string path = metricsPath("eerratic_metrics_timer_");
+    EEerraticVirtualClock clock(0, 1);
+    EEerraticVirtualClock::Event event(clock);
+    EEerraticTimer timer(50,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    timer.addStep(3, 20, nullptr, SLEEP_REMAINING_TIME);
+    timer.addStep(7, 10, [&event] { return event.isSet(); }, WAIT_EVENT);
+
+    EEerraticMetricsExporter exporter(path, 4);
+    EEerraticMetricsReader reader(path);
+    EXPECT_EQ(reader.getStepCount(), 0u);
+    EXPECT_EQ(reader.getTicksPerSec(), static_cast<uint64_t>(EERRATIC_TICKS_PER_SEC));
+
+    timer.setMetricsExporter(&exporter);
+    timer.resetLoop();
+    timer.executeSleep(3);
+    timer.executeSleep(7);          // Times out after 10
+    clock.advance(30);              // Loop of 60 > 50
+    timer.resetLoop();
+    event.setAt(clock.now() + 5);
+    timer.executeSleep(3);
+    timer.executeSleep(7);
+    timer.resetLoop();
+
+    ASSERT_EQ(reader.getStepCount(), 2u);
+    EEerraticMetricsReader::StepSnapshot step;
+    ASSERT_TRUE(reader.readStep(0, step));
+    EXPECT_EQ(step.stepId, 3);
+    EXPECT_EQ(step.count, 2u);
+    EXPECT_EQ(step.timeoutCount, 0u);
+    EXPECT_EQ(step.lastElapsed, 20u);
+    ASSERT_TRUE(reader.readStep(1, step));
+    EXPECT_EQ(step.stepId, 7);
+    EXPECT_EQ(step.count, 2u);
+    EXPECT_EQ(step.timeoutCount, 1u);
+    EXPECT_EQ(step.maxElapsed, 10u);
+    EXPECT_FALSE(reader.readStep(2, step));
+
+    const EEerraticMetricsReader::LoopSnapshot loop = reader.readLoop();
+    EXPECT_EQ(loop.loopCount, 2u);
+    EXPECT_EQ(loop.loopOverrunCount, 1u);
+    EXPECT_EQ(loop.maxLoopElapsed, 60u);
+    EXPECT_LT(loop.lastLoopElapsed, 50u);
+    std::remove(path.c_str());
+}
+
+TEST(eerratic_metrics, test_reader_sees_consistent_snapshots) {
+    const std::string path = metricsPath("eerratic_metrics_seqlock_");
+    EEerraticMetricsExporter exporter(path, 1);
+    EEerraticMetricsReader reader(path);
+
+    // Every record writes elapsed == count, so a torn read shows up as a mismatch
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        for (eerratic_tick_t i = 1; i <= 200000; i++) {
+            exporter.recordStep(0, 1, i, ERROR_CODE_OK);
+        }
+        done = true;
+    });
+    EEerraticMetricsReader::StepSnapshot step;
+    uint64_t reads = 0;
+    while (!done || reads == 0) {
+        if (reader.readStep(0, step)) {
+            ASSERT_EQ(step.lastElapsed, step.count);
+            ASSERT_EQ(step.maxElapsed, step.count);
+            reads++;
+        }
+    }
+    writer.join();
+    ASSERT_TRUE(reader.readStep(0, step));
+    EXPECT_EQ(step.count, 200000u);
+    std::remove(path.c_str());
+}
+
+TEST(eerratic_metrics, test_reader_rejects_other_files) {
+    const std::string path = metricsPath("eerratic_metrics_bad_");
+    FILE* file = std::fopen(path.c_str(), "w");
+    ASSERT_NE(file, nullptr);
+    std::fputs("not metrics", file);
+    std::fclose(file);
+    EXPECT_THROW(EEerraticMetricsReader reader(path), std::runtime_error);
+    std::remove(path.c_str());
+    EXPECT_THROW(EEerraticMetricsReader reader(path), std::runtime_error);
+}
+
+TEST(eerratic_metrics, test_reader_reports_abandoned_update) {
+    const std::string path = metricsPath("eerratic_metrics_abandoned_");
+    EEerraticMetricsExporter exporter(path, 1);
+    EEerraticMetricsReader reader(path);
+    exporter.recordStep(0, 4, 5, ERROR_CODE_OK);
+    exporter.recordLoop(10, false);
+
+    // A writer that died mid-update leaves both sequences odd
+    const size_t size = sizeof(EEerraticMetricsHeader) + sizeof(EEerraticMetricsStep);
+    const int fd = open(path.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(memory, MAP_FAILED);
+    EEerraticMetricsHeader* header = static_cast<EEerraticMetricsHeader*>(memory);
+    EEerraticMetricsStep* step = reinterpret_cast<EEerraticMetricsStep*>(header + 1);
+    header->loopSeq.fetch_add(1);
+    step->seq.fetch_add(1);
+
+    EEerraticMetricsReader::StepSnapshot snapshot;
+    ASSERT_TRUE(reader.readStep(0, snapshot));
+    EXPECT_TRUE(snapshot.torn);
+    EXPECT_EQ(snapshot.stepId, 4);
+    EXPECT_EQ(snapshot.count, 1u);
+    EXPECT_TRUE(reader.readLoop().torn);
+
+    header->loopSeq.fetch_add(1);
+    step->seq.fetch_add(1);
+    ASSERT_TRUE(reader.readStep(0, snapshot));
+    EXPECT_FALSE(snapshot.torn);
+    EXPECT_FALSE(reader.readLoop().torn);
+    munmap(memory, size);
+    std::remove(path.c_str());
+}
+
+TEST(eerratic_metrics, test_reader_bounds_corrupt_header) {
+    const std::string path = metricsPath("eerratic_metrics_corrupt_");
+    EEerraticMetricsExporter exporter(path, 2);
+    EEerraticMetricsReader reader(path);
+    exporter.recordStep(0, 1, 5, ERROR_CODE_OK);
+
+    // Another writer claims far more slots than the file holds
+    const int fd = open(path.c_str(), O_RDWR);
+    ASSERT_GE(fd, 0);
+    void* memory = mmap(nullptr, sizeof(EEerraticMetricsHeader), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    ASSERT_NE(memory, MAP_FAILED);
+    EEerraticMetricsHeader* header = static_cast<EEerraticMetricsHeader*>(memory);
+    header->stepCapacity = 100000;
+    header->stepCount.store(100000);
+
+    EXPECT_EQ(reader.getStepCount(), 2u);
+    EEerraticMetricsReader::StepSnapshot step;
+    EXPECT_TRUE(reader.readStep(1, step));
+    EXPECT_FALSE(reader.readStep(2, step));
+    EXPECT_FALSE(reader.readStep(99999, step));
+    EXPECT_THROW(EEerraticMetricsReader corrupt(path), std::runtime_error);
+    munmap(memory, sizeof(EEerraticMetricsHeader));
+    std::remove(path.c_str());
+}
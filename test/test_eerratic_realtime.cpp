@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include "eerratic_realtime.hpp"
+#include "eerratic_scheduler.hpp"
+
+#include <chrono>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+// Settings are applied on throwaway threads so the test runner keeps its own.
+// Memory locking is process-wide and is left out.
+static EEerraticRealtime::Report applyOnThread(const EEerraticRealtime::Config& config) {
+    EEerraticRealtime::Report report;
+    std::thread thread([&] { report = EEerraticRealtime::apply(config); });
+    thread.join();
+    return report;
+}
+
+TEST(eerratic_realtime, test_nothing_requested) {
+    EEerraticRealtime::Report report = applyOnThread(EEerraticRealtime::Config{});
+    EXPECT_TRUE(report.allApplied());
+    EXPECT_EQ(report.describe(), "");
+}
+
+#ifdef __linux__
+TEST(eerratic_realtime, test_unprivileged_settings) {
+    EEerraticRealtime::Config config;
+    config.cpus = { sched_getcpu() };
+    config.timerSlackNs = 1;
+    config.prefaultStackBytes = 64 * 1024;
+    EEerraticRealtime::Report report = applyOnThread(config);
+    EXPECT_EQ(report.affinity.status, EEerraticRealtime::Status::Applied);
+    EXPECT_EQ(report.timerSlack.status, EEerraticRealtime::Status::Applied);
+    EXPECT_EQ(report.stackPrefault.status, EEerraticRealtime::Status::Applied);
+    EXPECT_EQ(report.priority.status, EEerraticRealtime::Status::NotRequested);
+    EXPECT_TRUE(report.allApplied());
+    EXPECT_EQ(report.describe(), "affinity: applied\ntimer_slack: applied\nstack_prefault: applied\n");
+}
+
+TEST(eerratic_realtime, test_stack_prefault_clamped) {
+    EEerraticRealtime::Config config;
+    config.prefaultStackBytes = size_t(1) << 40;
+    EEerraticRealtime::Report report = applyOnThread(config);
+    EXPECT_EQ(report.stackPrefault.status, EEerraticRealtime::Status::Partial);
+    EXPECT_EQ(report.stackPrefault.error, ENOMEM);
+    EXPECT_FALSE(report.allApplied());
+    EXPECT_EQ(report.describe().rfind("stack_prefault: partial (", 0), 0u);
+}
+
+TEST(eerratic_realtime, test_degrades_without_privileges) {
+    EEerraticRealtime::Config config;
+    config.fifoPriority = 10;
+    config.cpus = { -1 };
+    EEerraticRealtime::Report report = applyOnThread(config);
+    EXPECT_EQ(report.affinity.status, EEerraticRealtime::Status::Failed);
+    EXPECT_FALSE(report.allApplied());
+    // Depends on the privileges of the test run, but never left unreported
+    EXPECT_NE(report.priority.status, EEerraticRealtime::Status::NotRequested);
+    if (report.priority.status == EEerraticRealtime::Status::Failed) {
+        EXPECT_NE(report.priority.error, 0);
+    }
+}
+
+TEST(eerratic_realtime, test_scheduler_workers) {
+    EEerraticScheduler scheduler(2, [] {
+        return static_cast<eerratic_tick_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    });
+    EEerraticRealtime::Config config;
+    config.timerSlackNs = 1000;
+    scheduler.setRealtimeConfig(config);
+    scheduler.start();
+    std::vector<EEerraticRealtime::Report> reports = scheduler.getRealtimeReports();
+    scheduler.stop();
+
+    ASSERT_EQ(reports.size(), 2u);
+    for (const EEerraticRealtime::Report& report : reports) {
+        EXPECT_EQ(report.timerSlack.status, EEerraticRealtime::Status::Applied);
+    }
+    EXPECT_THROW({
+        scheduler.start();
+        scheduler.setRealtimeConfig(config);
+    }, std::logic_error);
+    scheduler.stop();
+}
+#endif
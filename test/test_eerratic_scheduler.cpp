@@ -0,0 +1,84 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include "eerratic_scheduler.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static eerratic_tick_t get_steady_time_impl() {
+    using namespace std::chrono;
+    return static_cast<eerratic_tick_t>(
+        duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count()
+    );
+}
+
+TEST(eerratic_scheduler, test_many_loops_on_few_workers) {
+    const int kLoopCount = 16;
+    EEerraticScheduler scheduler(2, get_steady_time_impl);
+
+    std::atomic<int> stepsDone{0};
+    EEerraticScheduler::LoopHandle loops[kLoopCount];
+    for (int i = 0; i < kLoopCount; i++) {
+        loops[i] = scheduler.addLoop(10, [&stepsDone](int, ERROR_CODE result, eerratic_tick_t) {
+            EXPECT_EQ(result, ERROR_CODE_OK);
+            stepsDone++;
+        });
+        scheduler.addStep(loops[i], 0, 3, nullptr, SLEEP_REMAINING_TIME);
+        scheduler.addStep(loops[i], 1, 10, nullptr, SLEEP_REMAINING_TIME);
+    }
+
+    scheduler.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(105));
+    scheduler.stop();
+
+    for (int i = 0; i < kLoopCount; i++) {
+        EXPECT_GE(scheduler.getLoopCount(loops[i]), 8u);
+        EXPECT_LE(scheduler.getLoopCount(loops[i]), 11u);
+        EXPECT_EQ(scheduler.getTimeoutCount(loops[i]), 0u);
+    }
+    EXPECT_GE(stepsDone.load(), kLoopCount * 16);
+}
+
+TEST(eerratic_scheduler, test_event_steps) {
+    EEerraticScheduler scheduler(1, get_steady_time_impl, 1000);
+
+    std::atomic<bool> event{false};
+    std::atomic<int> okCount{0};
+    std::atomic<int> timeoutCount{0};
+    std::atomic<eerratic_tick_t> lastElapsed{0};
+    auto loop = scheduler.addLoop(1000, [&](int id, ERROR_CODE result, eerratic_tick_t elapsed) {
+        if (id != 0) {
+            return;
+        }
+        (result == ERROR_CODE_OK ? okCount : timeoutCount)++;
+        lastElapsed = elapsed;
+    });
+    scheduler.addStep(loop, 0, 500, [&event] { return event.load(); }, WAIT_EVENT);
+    scheduler.addStep(loop, 1, 1000, nullptr, SLEEP_REMAINING_TIME);
+
+    scheduler.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    event = true;
+    // Without notify() the event would only be seen at the 1000 ms poll interval
+    scheduler.notify();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    scheduler.stop();
+
+    EXPECT_EQ(okCount.load(), 1);
+    EXPECT_EQ(timeoutCount.load(), 0);
+    EXPECT_NEAR(lastElapsed.load(), 50, 10);
+}
+
+TEST(eerratic_scheduler, test_invalid_arguments) {
+    EXPECT_THROW(EEerraticScheduler(0, get_steady_time_impl), std::invalid_argument);
+    EEerraticScheduler scheduler(1, get_steady_time_impl);
+    auto loop = scheduler.addLoop(100);
+    EXPECT_THROW(scheduler.addStep(loop, 0, 10, nullptr, WAIT_EVENT), std::invalid_argument);
+    EXPECT_THROW(scheduler.getLoopCount(EEerraticScheduler::LoopHandle{ 5 }), std::out_of_range);
+}
@@ -6,37 +6,48 @@
 
 #include <gtest/gtest.h>
 #include "eerratic_timer.h"
+#include "eerratic_virtual_clock.hpp"
 
 #include <atomic>
-#include <chrono>
-#include <iostream>
-#include <thread>
+#include <memory>
 
-std::atomic<bool> flag{false};
+// All tests run against simulated time, so expectations are exact and the
+// suite does not depend on scheduler latency.
+std::unique_ptr<EEerraticVirtualClock> virtual_clock;
+std::unique_ptr<EEerraticVirtualClock::Event> event;
+uint32_t poll_count = 0;
 
-uint32_t get_current_time_impl() {
-    using namespace std::chrono;
-    return static_cast<uint32_t>(
-        duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count()
-    );
+void reset_virtual_clock(eerratic_tick_t start_time, eerratic_tick_t poll_cost = 1) {
+    event.reset();
+    virtual_clock.reset(new EEerraticVirtualClock(start_time, poll_cost));
+    event.reset(new EEerraticVirtualClock::Event(*virtual_clock));
+    poll_count = 0;
 }
 
-void sleep_ms_impl(uint32_t ms) {
-    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+eerratic_tick_t get_current_time_impl() {
+    return virtual_clock->now();
+}
+
+void sleep_ms_impl(eerratic_tick_t ms) {
+    virtual_clock->sleep(ms);
 }
 
 bool is_event_set_impl() {
-    return flag.load();
+    poll_count++;
+    return event->isSet();
+}
+
+bool wait_event_impl(eerratic_tick_t timeout) {
+    return event->wait(timeout);
 }
 
-void thread_func() {
-    std::this_thread::sleep_for(std::chrono::seconds(5));
-    flag.store(true);
+void yield_impl() {
 }
 
 TEST(eerratic_timer, test_eerratic_timer) {
-    const uint32_t loop_start_time = get_current_time_impl();
-    const uint32_t loop_expected_elapsed_time = 7000;
+    reset_virtual_clock(123456);
+    const eerratic_tick_t loop_start_time = get_current_time_impl();
+    const eerratic_tick_t loop_expected_elapsed_time = 7000;
 
     timer_utils_t timer_func_base;
     timer_func_base.get_current_time_func = get_current_time_impl;
@@ -51,28 +62,265 @@ TEST(eerratic_timer, test_eerratic_timer) {
     timer_step_1.expected_elapsed_time = 500;
     timer_step_2.expected_elapsed_time = loop_expected_elapsed_time;
 
-    std::thread th(thread_func);
-    th.detach();
+    event->setAt(get_current_time_impl() + 5000);
     ERROR_CODE ret_0 = eerratic_sleep(loop_start_time, loop_expected_elapsed_time, &timer_step_0, WAIT_EVENT);
     EXPECT_EQ(ret_0, ERROR_CODE_OK);
-    EXPECT_NEAR(timer_step_0.elapsed_time, 5000, 2);
+    EXPECT_EQ(timer_step_0.elapsed_time, 5000u);
 
-    flag = false;
-    std::thread th2(thread_func);
-    th2.detach();
+    event->clear();
+    event->setAt(get_current_time_impl() + 5000);
     ERROR_CODE ret_1 = eerratic_sleep(loop_start_time, loop_expected_elapsed_time, &timer_step_1, WAIT_EVENT);
     EXPECT_EQ(ret_1, ERROR_CODE_TIMEOUT);
-    EXPECT_NEAR(timer_step_1.elapsed_time, 500, 2);
+    EXPECT_EQ(timer_step_1.elapsed_time, 500u);
 
     ERROR_CODE ret_2 = eerratic_sleep(loop_start_time, loop_expected_elapsed_time, &timer_step_2, SLEEP_REMAINING_TIME);
     EXPECT_EQ(ret_2, ERROR_CODE_OK);
 
-    uint32_t elapsed_time = get_current_time_impl() - loop_start_time;
-    EXPECT_NEAR(elapsed_time, loop_expected_elapsed_time, 2);
+    eerratic_tick_t elapsed_time = get_current_time_impl() - loop_start_time;
+    EXPECT_EQ(elapsed_time, loop_expected_elapsed_time);
+}
+
+TEST(eerratic_timer, test_wait_time_and_event) {
+    reset_virtual_clock(0);
+    timer_utils_t timer_step{};
+    timer_step.get_current_time_func = get_current_time_impl;
+    timer_step.sleep_func = sleep_ms_impl;
+    timer_step.is_event_set_func = is_event_set_impl;
+    timer_step.expected_elapsed_time = 300;
+
+    event->setAt(100);
+    EXPECT_EQ(eerratic_sleep(0, 1000, &timer_step, WAIT_TIME_AND_EVENT), ERROR_CODE_OK);
+    EXPECT_EQ(timer_step.elapsed_time, 300u);
+
+    // The loop budget caps the step
+    event->clear();
+    event->setAt(get_current_time_impl() + 50);
+    timer_step.expected_elapsed_time = 500;
+    EXPECT_EQ(eerratic_sleep(0, 600, &timer_step, WAIT_TIME_AND_EVENT), ERROR_CODE_OK);
+    EXPECT_EQ(get_current_time_impl(), 600u);
+}
+
+TEST(eerratic_timer, test_wait_policy_block) {
+    reset_virtual_clock(0, 0);
+    const eerratic_tick_t loop_start_time = get_current_time_impl();
+    const eerratic_tick_t loop_expected_elapsed_time = 1000;
+
+    timer_utils_t timer_step{};
+    timer_step.get_current_time_func = get_current_time_impl;
+    timer_step.sleep_func = sleep_ms_impl;
+    timer_step.is_event_set_func = is_event_set_impl;
+    timer_step.expected_elapsed_time = 200;
+    wait_backend_t backend = { WAIT_POLICY_BLOCK, NULL, NULL };
+
+    ERROR_CODE ret = eerratic_sleep_with_backend(loop_start_time, loop_expected_elapsed_time, &timer_step, WAIT_EVENT, &backend);
+    EXPECT_EQ(ret, ERROR_CODE_TIMEOUT);
+    EXPECT_EQ(timer_step.elapsed_time, 200u);
+    // Parked in 1 ms slices instead of spinning
+    EXPECT_LE(poll_count, 201u);
+
+    // With a wait_event_func the thread parks until the event in one call
+    backend.wait_event_func = wait_event_impl;
+    poll_count = 0;
+    event->setAt(get_current_time_impl() + 120);
+    ret = eerratic_sleep_with_backend(loop_start_time, loop_expected_elapsed_time, &timer_step, WAIT_EVENT, &backend);
+    EXPECT_EQ(ret, ERROR_CODE_OK);
+    EXPECT_EQ(timer_step.elapsed_time, 120u);
+    EXPECT_EQ(poll_count, 2u);
+}
+
+TEST(eerratic_timer, test_wait_policy_adaptive) {
+    reset_virtual_clock(0, 0);
+    const eerratic_tick_t loop_start_time = get_current_time_impl();
+    const eerratic_tick_t loop_expected_elapsed_time = 1000;
+
+    timer_utils_t timer_step{};
+    timer_step.get_current_time_func = get_current_time_impl;
+    timer_step.sleep_func = sleep_ms_impl;
+    timer_step.is_event_set_func = is_event_set_impl;
+    timer_step.expected_elapsed_time = 500;
+    wait_backend_t backend = { WAIT_POLICY_ADAPTIVE, yield_impl, NULL };
+
+    event->setAt(100);
+    ERROR_CODE ret = eerratic_sleep_with_backend(loop_start_time, loop_expected_elapsed_time, &timer_step, WAIT_EVENT, &backend);
+    EXPECT_EQ(ret, ERROR_CODE_OK);
+    EXPECT_EQ(timer_step.elapsed_time, 100u);
+    // Spin, then yield, then one poll per 1 ms block slice
+    EXPECT_EQ(poll_count, EERRATIC_ADAPTIVE_SPIN_COUNT + EERRATIC_ADAPTIVE_YIELD_COUNT + 101u);
+}
+
+TEST(eerratic_timer, test_tick_wrap_around) {
+    const eerratic_tick_t loop_start_time = UINT32_MAX - 10;
+    reset_virtual_clock(5); // wrapped: 16 ticks after loop start
+
+    EXPECT_EQ(is_timer_expired(loop_start_time, 100, UINT32_MAX - 5, 20, get_current_time_impl), ERROR_CODE_OK);
+    virtual_clock->advance(15); // 26 ticks after step start
+    EXPECT_EQ(is_timer_expired(loop_start_time, 100, UINT32_MAX - 5, 20, get_current_time_impl), ERROR_CODE_TIMEOUT);
+    virtual_clock->advance(75); // 106 ticks after loop start
+    EXPECT_EQ(is_timer_expired(loop_start_time, 100, UINT32_MAX - 5, 20, get_current_time_impl), ERROR_CODE_TOTAL_TIMEOUT);
+
+    timer_utils_t timer_step{};
+    timer_step.get_current_time_func = get_current_time_impl;
+    timer_step.sleep_func = sleep_ms_impl;
+    timer_step.expected_elapsed_time = 100;
+
+    reset_virtual_clock(UINT32_MAX - 5);
+    ERROR_CODE ret = eerratic_sleep(loop_start_time, 100, &timer_step, SLEEP_REMAINING_TIME);
+    EXPECT_EQ(ret, ERROR_CODE_OK);
+    EXPECT_EQ(timer_step.elapsed_time, 95u);
+    EXPECT_EQ(get_current_time_impl(), 89u);
+}
+
+TEST(eerratic_timer, test_context_callbacks) {
+    EEerraticVirtualClock clocks[2] = { EEerraticVirtualClock(0), EEerraticVirtualClock(0) };
+    EEerraticVirtualClock::Event events[2] = { EEerraticVirtualClock::Event(clocks[0]), EEerraticVirtualClock::Event(clocks[1]) };
+    timer_utils_ctx_t timer_steps[2] = {};
+
+    for (int i = 0; i < 2; i++) {
+        clocks[i].bind(timer_steps[i], &events[i]);
+        timer_steps[i].expected_elapsed_time = 50;
+    }
+    events[0].setAt(30);
+    events[1].setAt(70);
 
+    EXPECT_EQ(eerratic_sleep_ctx(0, 100, &timer_steps[0], WAIT_EVENT), ERROR_CODE_OK);
+    EXPECT_EQ(timer_steps[0].elapsed_time, 30u);
+    EXPECT_EQ(eerratic_sleep_ctx(0, 100, &timer_steps[1], WAIT_EVENT), ERROR_CODE_TIMEOUT);
+    EXPECT_EQ(timer_steps[1].elapsed_time, 50u);
+
+    EXPECT_EQ(eerratic_sleep_ctx(0, 100, &timer_steps[0], SLEEP_REMAINING_TIME), ERROR_CODE_OK);
+    EXPECT_EQ(clocks[0].now(), 80u);
+    EXPECT_EQ(clocks[1].now(), 50u);
+}
+
+TEST(eerratic_timer, test_step_poll) {
+    EEerraticVirtualClock clock(0);
+    EEerraticVirtualClock::Event stepEvent(clock);
+    timer_utils_ctx_t timer_utils{};
+    clock.bind(timer_utils, &stepEvent);
+
+    step_poll_t step;
+    eerratic_tick_t wake_time = 0;
+    step_poll_begin(&step, 300, WAIT_TIME_AND_EVENT, clock.now());
+    stepEvent.setAt(100);
+
+    EXPECT_EQ(step_poll(&step, 0, 1000, clock.now(), &timer_utils, &wake_time), ERROR_CODE_PENDING);
+    EXPECT_EQ(wake_time, 300u);
+    clock.advance(99);
+    EXPECT_EQ(step_poll(&step, 0, 1000, clock.now(), &timer_utils, &wake_time), ERROR_CODE_PENDING);
+    EXPECT_TRUE(step.event_seen);
+    EXPECT_EQ(wake_time, 300u);
+    clock.advance(200);
+    EXPECT_EQ(step_poll(&step, 0, 1000, clock.now(), &timer_utils, &wake_time), ERROR_CODE_OK);
+    EXPECT_EQ(step.elapsed_time, 300u);
+
+    step_poll_begin(&step, 50, WAIT_EVENT, clock.now());
+    stepEvent.clear();
+    clock.advance(60);
+    EXPECT_EQ(step_poll(&step, 0, 1000, clock.now(), &timer_utils, &wake_time), ERROR_CODE_TIMEOUT);
+}
+
+void sleep_overshoot_impl(eerratic_tick_t ms) {
+    virtual_clock->sleep(ms + 3);
+}
+
+void yield_tick_impl() {
+    virtual_clock->advance(1);
+}
+
+TEST(eerratic_timer, test_precise_sleep) {
+    reset_virtual_clock(1000);
+    legacy_funcs_t funcs = { get_current_time_impl, NULL, sleep_overshoot_impl, NULL, NULL };
+    wait_backend_t backend = { WAIT_POLICY_YIELD, yield_tick_impl, NULL };
+    timer_utils_ctx_t timer_utils = make_legacy_timer_utils_ctx(&funcs, &backend);
+    precise_sleep_t precise_sleep;
+    precise_sleep_init(&precise_sleep);
+    timer_utils.precise_sleep = &precise_sleep;
+    timer_utils.expected_elapsed_time = 100;
+
+    // The first sleep overshoots past the initial margin, then the margin covers it
+    for (int i = 0; i < 10; i++) {
+        const eerratic_tick_t loop_start_time = get_current_time_impl();
+        EXPECT_EQ(eerratic_sleep_ctx(loop_start_time, 100, &timer_utils, SLEEP_REMAINING_TIME_PRECISE), ERROR_CODE_OK);
+        EXPECT_EQ(timer_utils.elapsed_time, i == 0 ? 100u + 3 - EERRATIC_PRECISE_INITIAL_MARGIN : 100u);
+    }
+    EXPECT_EQ(precise_sleep.margin, 4u);
+    EXPECT_EQ(precise_sleep.last_error, 0u);
+    EXPECT_EQ(precise_sleep.max_error, 3u - EERRATIC_PRECISE_INITIAL_MARGIN);
+    EXPECT_EQ(precise_sleep.count, 10u);
+
+    // Without state the initial margin is used and nothing is learned
+    timer_utils.precise_sleep = NULL;
+    const eerratic_tick_t loop_start_time = get_current_time_impl();
+    EXPECT_EQ(eerratic_sleep_ctx(loop_start_time, 50, &timer_utils, SLEEP_REMAINING_TIME_PRECISE), ERROR_CODE_OK);
+    EXPECT_EQ(timer_utils.elapsed_time, 50u + 3 - EERRATIC_PRECISE_INITIAL_MARGIN);
+}
+
+eerratic_tick_t event_fire_time[3];
+
+// Reads all three events in one call, like loading an atomic word
+uint32_t get_event_mask_impl() {
+    virtual_clock->advance(1);
+    uint32_t mask = 0;
+    for (uint32_t index = 0; index < 3; index++) {
+        if (virtual_clock->now() >= event_fire_time[index]) {
+            mask |= 1u << index;
+        }
+    }
+    return mask;
+}
+
+TEST(eerratic_timer, test_wait_event_set) {
+    reset_virtual_clock(1000);
+    event_set_t event_set{};
+    event_set.wait_mask = 0x7;
+    eerratic_tick_t elapsed_time = 0;
+    auto wait = [&](eerratic_tick_t loop_start_time, sleep_type_t sleep_type) {
+        return wait_event_set(loop_start_time, 1000, 100, &elapsed_time,
+            get_current_time_impl, get_event_mask_impl, NULL, &event_set, sleep_type, NULL);
+    };
+
+    eerratic_tick_t loop_start_time = get_current_time_impl();
+    event_fire_time[0] = loop_start_time + 30;
+    event_fire_time[1] = loop_start_time + 10;
+    event_fire_time[2] = loop_start_time + 50;
+    EXPECT_EQ(wait(loop_start_time, WAIT_ANY_EVENT), ERROR_CODE_OK);
+    EXPECT_EQ(elapsed_time, 10u);
+    EXPECT_EQ(event_set.fired_mask, 0x2u);
+    EXPECT_EQ(event_set.fired_time[1], 10u);
+
+    loop_start_time = get_current_time_impl();
+    event_fire_time[0] = loop_start_time + 30;
+    event_fire_time[1] = loop_start_time + 10;
+    event_fire_time[2] = loop_start_time + 50;
+    EXPECT_EQ(wait(loop_start_time, WAIT_ALL_EVENTS), ERROR_CODE_OK);
+    EXPECT_EQ(elapsed_time, 50u);
+    EXPECT_EQ(event_set.fired_mask, 0x7u);
+    EXPECT_EQ(event_set.fired_time[0], 30u);
+    EXPECT_EQ(event_set.fired_time[1], 10u);
+    EXPECT_EQ(event_set.fired_time[2], 50u);
+
+    // A timeout still reports the events that did fire
+    loop_start_time = get_current_time_impl();
+    event_fire_time[2] = loop_start_time + 500;
+    EXPECT_EQ(wait(loop_start_time, WAIT_ALL_EVENTS), ERROR_CODE_TIMEOUT);
+    EXPECT_EQ(elapsed_time, 100u);
+    EXPECT_EQ(event_set.fired_mask, 0x3u);
+
+    event_set.wait_mask = 0;
+    EXPECT_EQ(wait(loop_start_time, WAIT_ANY_EVENT), ERROR_CODE_INVALID_PARAMETER);
+    EXPECT_EQ(wait_event_set(loop_start_time, 1000, 100, &elapsed_time,
+        get_current_time_impl, get_event_mask_impl, NULL, NULL, WAIT_ANY_EVENT, NULL), ERROR_CODE_NULL_POINTER);
+
+    // timer_utils_t has no event source for these steps
+    timer_utils_t timer_step;
+    timer_step.get_current_time_func = get_current_time_impl;
+    timer_step.is_event_set_func = NULL;
+    timer_step.sleep_func = NULL;
+    timer_step.expected_elapsed_time = 100;
+    EXPECT_EQ(eerratic_sleep(loop_start_time, 1000, &timer_step, WAIT_ANY_EVENT), ERROR_CODE_NULL_POINTER);
 }
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
-}
\ No newline at end of file
+}
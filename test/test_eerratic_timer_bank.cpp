@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include "eerratic_timer_bank.hpp"
+
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+TEST(eerratic_timer_bank, test_scan_matches_is_timer_expired) {
+    const size_t channelCount = 1000;    // Not a multiple of the block size
+    EEerraticTimerBank bank(channelCount);
+    EXPECT_EQ(bank.size(), channelCount);
+    EXPECT_EQ(bank.wordCount(), 16u);
+
+    // Times around the wrap of the tick type
+    const eerratic_tick_t now = static_cast<eerratic_tick_t>(5);
+    std::mt19937 random(42);
+    std::uniform_int_distribution<int> offset(-200, 200);
+    std::uniform_int_distribution<int> budget(0, 300);
+    struct Channel { eerratic_tick_t loopStart, loopBudget, start, stepBudget; };
+    std::vector<Channel> channels(channelCount);
+    for (size_t channel = 0; channel < channelCount; channel++) {
+        Channel& c = channels[channel];
+        c.loopStart = now + static_cast<eerratic_tick_t>(offset(random) - 200);
+        c.loopBudget = static_cast<eerratic_tick_t>(budget(random)) + 200;
+        c.start = now + static_cast<eerratic_tick_t>(offset(random) - 200);
+        c.stepBudget = static_cast<eerratic_tick_t>(budget(random));
+        bank.setChannel(channel, c.loopStart, c.loopBudget, c.start, c.stepBudget);
+    }
+    bank.disableChannel(7);
+
+    size_t expected = 0;
+    size_t timeouts = 0;
+    size_t totalTimeouts = 0;
+    const size_t expiredCount = bank.scan(now);
+    for (size_t channel = 0; channel < channelCount; channel++) {
+        const Channel& c = channels[channel];
+        const ERROR_CODE reference = (channel == 7) ? ERROR_CODE_OK
+            : check_timer_expired(c.loopStart, c.loopBudget, c.start, c.stepBudget, now);
+        ASSERT_EQ(bank.getResult(channel), reference) << "channel " << channel;
+        if (reference != ERROR_CODE_OK) {
+            expected++;
+        }
+        timeouts += (reference == ERROR_CODE_TIMEOUT);
+        totalTimeouts += (reference == ERROR_CODE_TOTAL_TIMEOUT);
+    }
+    EXPECT_EQ(expiredCount, expected);
+    EXPECT_GT(timeouts, 0u);
+    EXPECT_GT(totalTimeouts, 0u);
+
+    size_t visited = 0;
+    size_t previous = 0;
+    bank.forEachExpired([&](size_t channel, ERROR_CODE result) {
+        EXPECT_TRUE(visited == 0 || channel > previous);
+        EXPECT_EQ(result, bank.getResult(channel));
+        previous = channel;
+        visited++;
+    });
+    EXPECT_EQ(visited, expected);
+}
+
+TEST(eerratic_timer_bank, test_start_step_and_range) {
+    EEerraticTimerBank bank(3);
+    EXPECT_EQ(bank.scan(100), 0u);   // Nothing armed
+
+    bank.setChannel(2, 0, 100, 0, 10);
+    EXPECT_EQ(bank.scan(9), 0u);
+    EXPECT_EQ(bank.scan(10), 1u);
+    EXPECT_EQ(bank.getResult(2), ERROR_CODE_TIMEOUT);
+    EXPECT_EQ(bank.getTimeoutMask()[0], uint64_t(1) << 2);
+
+    bank.startStep(2, 10, 200);
+    EXPECT_EQ(bank.scan(50), 0u);
+    EXPECT_EQ(bank.scan(100), 1u);
+    EXPECT_EQ(bank.getResult(2), ERROR_CODE_TOTAL_TIMEOUT);
+    EXPECT_EQ(bank.getTimeoutMask()[0], 0u);
+
+    EXPECT_THROW(bank.setChannel(3, 0, 0, 0, 0), std::out_of_range);
+    EXPECT_THROW(bank.getResult(3), std::out_of_range);
+}
@@ -0,0 +1,681 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include "eerratic_schedule.hpp"
+#include "eerratic_timer_class.hpp"
+#include "eerratic_virtual_clock.hpp"
+
+#include <climits>
+
+eerratic_tick_t fake_now = 0;
+eerratic_tick_t fake_event_time = 0;
+
+eerratic_tick_t get_fake_time_impl() {
+    return fake_now;
+}
+
+void fake_sleep_impl(eerratic_tick_t ticks) {
+    fake_now += ticks;
+}
+
+// Every poll costs one tick; the event fires at fake_event_time
+bool is_fake_event_set_impl() {
+    fake_now++;
+    return fake_now >= fake_event_time;
+}
+
+TEST(eerratic_histogram, test_percentiles) {
+    EEerraticHistogram histogram;
+    for (eerratic_tick_t value = 1; value <= 1000; value++) {
+        histogram.record(value);
+    }
+    EXPECT_EQ(histogram.getTotalCount(), 1000u);
+    EXPECT_EQ(histogram.getMin(), 1u);
+    EXPECT_EQ(histogram.getMax(), 1000u);
+    EXPECT_NEAR(histogram.getValueAtPercentile(50.0), 500, 500 / 16);
+    EXPECT_NEAR(histogram.getValueAtPercentile(99.0), 990, 990 / 16);
+    EXPECT_EQ(histogram.getValueAtPercentile(100.0), 1000u);
+
+    histogram.reset();
+    EXPECT_EQ(histogram.getTotalCount(), 0u);
+    EXPECT_EQ(histogram.getValueAtPercentile(50.0), 0u);
+}
+
+TEST(eerratic_histogram, test_bucket_bounds) {
+    for (eerratic_tick_t value : {0u, 1u, 15u, 16u, 17u, 1000u, 123456u, 0xFFFFFFFFu}) {
+        unsigned index = EEerraticHistogram::bucketIndex(static_cast<eerratic_tick_t>(value));
+        ASSERT_LT(index, EEerraticHistogram::kBucketCount);
+        EXPECT_GE(EEerraticHistogram::bucketUpperBound(index), static_cast<eerratic_tick_t>(value));
+    }
+}
+
+TEST(eerratic_timer_class, test_step_stats) {
+    fake_now = 0;
+    EEerraticTimer timer(200, get_fake_time_impl, fake_sleep_impl);
+    timer.addStep(0, 80, is_fake_event_set_impl, WAIT_EVENT);
+    timer.addStep(1, 200, nullptr, SLEEP_REMAINING_TIME);
+
+    for (eerratic_tick_t i = 1; i <= 100; i++) {
+        timer.resetLoop();
+        fake_event_time = fake_now + i;
+        timer.executeSleep(0);
+        timer.executeSleep(1);
+    }
+
+    EEerraticTimer::StepStats stats{};
+    ASSERT_EQ(timer.getStepStats(0, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.count, 100u);
+    EXPECT_EQ(stats.overrunCount, 20u);
+    EXPECT_EQ(stats.min, 1u);
+    EXPECT_EQ(stats.max, 80u);
+    EXPECT_NEAR(stats.p50, 50, 4);
+    EXPECT_EQ(stats.p99, 80u);
+    EXPECT_EQ(stats.maxJitter, 1u);
+    EXPECT_NEAR(stats.meanJitter, 79.0 / 99.0, 1e-9);
+
+    ASSERT_EQ(timer.getStepStats(1, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.count, 100u);
+    EXPECT_EQ(stats.overrunCount, 0u);
+
+    EXPECT_EQ(timer.getStepStats(2, stats), ERROR_CODE_INVALID_PARAMETER);
+    EXPECT_EQ(timer.getStepHistogram(2), nullptr);
+
+    timer.resetStats();
+    ASSERT_EQ(timer.getStepStats(0, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.count, 0u);
+    EXPECT_EQ(stats.overrunCount, 0u);
+}
+
+TEST(eerratic_timer_class, test_callable_steps) {
+    struct Channel {
+        eerratic_tick_t now = 0;
+        eerratic_tick_t eventTime = 0;
+    };
+    Channel channels[2];
+    EEerraticTimer timers[2] = {
+        EEerraticTimer(100, [&channels] { return channels[0].now; }, [&channels](eerratic_tick_t t) { channels[0].now += t; }),
+        EEerraticTimer(100, [&channels] { return channels[1].now; }, [&channels](eerratic_tick_t t) { channels[1].now += t; }),
+    };
+
+    for (int i = 0; i < 2; i++) {
+        Channel* channel = &channels[i];
+        timers[i].addStep(0, 50, [channel] { return ++channel->now >= channel->eventTime; }, WAIT_EVENT);
+        timers[i].addStep(1, 100, nullptr, SLEEP_REMAINING_TIME);
+        timers[i].resetLoop();
+    }
+    channels[0].eventTime = 20;
+    channels[1].eventTime = 60;
+
+    EXPECT_EQ(timers[0].executeSleep(0), ERROR_CODE_OK);
+    EXPECT_EQ(timers[0].getLastElapsedTime(), 20u);
+    EXPECT_EQ(timers[1].executeSleep(0), ERROR_CODE_TIMEOUT);
+    EXPECT_EQ(timers[1].getLastElapsedTime(), 50u);
+    EXPECT_EQ(timers[0].executeSleep(1), ERROR_CODE_OK);
+    EXPECT_EQ(channels[0].now, 100u);
+    EXPECT_EQ(channels[1].now, 50u);
+}
+
+TEST(eerratic_timer_class, test_sparse_step_ids) {
+    EEerraticVirtualClock clock;
+    EEerraticTimer timer(100,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    const int ids[] = { INT_MAX, 1000000, -7, 3 };
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(timer.addStep(ids[i], 10, nullptr, SLEEP_REMAINING_TIME).index, static_cast<uint32_t>(i));
+    }
+    // Re-adding an id keeps its slot
+    EXPECT_EQ(timer.addStep(1000000, 20, nullptr, SLEEP_REMAINING_TIME).index, 1u);
+
+    timer.resetLoop();
+    for (int id : ids) {
+        EXPECT_EQ(timer.executeSleep(id), ERROR_CODE_OK);
+    }
+    EXPECT_EQ(clock.now(), 50u);
+    EEerraticTimer::StepStats stats;
+    ASSERT_EQ(timer.getStepStats(INT_MAX, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.count, 1u);
+    EXPECT_EQ(timer.getStepHandle(1000000).index, 1u);
+    EXPECT_EQ(timer.executeSleep(999999), ERROR_CODE_INVALID_PARAMETER);
+    EXPECT_EQ(timer.executeSleep(INT_MIN), ERROR_CODE_INVALID_PARAMETER);
+}
+
+TEST(eerratic_timer_class, test_member_pointer_callback) {
+    struct Sensor {
+        bool ready;
+        bool isReady() const { return ready; }
+    };
+    EEerraticCallback<bool(const Sensor&)> readField(&Sensor::ready);
+    EEerraticCallback<bool(const Sensor&)> callMethod(&Sensor::isReady);
+    EEerraticCallback<bool(const Sensor&)> null(static_cast<bool (Sensor::*)() const>(nullptr));
+    EXPECT_TRUE(readField(Sensor{ true }));
+    EXPECT_FALSE(callMethod(Sensor{ false }));
+    EXPECT_FALSE(null);
+}
+
+TEST(eerratic_timer_class, test_null_time_function) {
+    EXPECT_THROW(EEerraticTimer(100, static_cast<get_current_time_func_t>(nullptr), fake_sleep_impl), std::invalid_argument);
+}
+
+TEST(eerratic_timer_class, test_event_set_step) {
+    EEerraticVirtualClock clock(1000, 0);
+    EEerraticVirtualClock::Event imu(clock);
+    EEerraticVirtualClock::Event lidar(clock);
+    EEerraticTimer timer(100,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    auto getEventMask = [&imu, &lidar] {
+        return (imu.isSet() ? 0x1u : 0u) | (lidar.isSet() ? 0x2u : 0u);
+    };
+    timer.addStep(0, 40, getEventMask, 0x3, WAIT_ANY_EVENT, WAIT_POLICY_BLOCK);
+    timer.addStep(1, 40, getEventMask, 0x3, WAIT_ALL_EVENTS, WAIT_POLICY_BLOCK);
+
+    timer.resetLoop();
+    lidar.setAt(clock.now() + 5);
+    imu.setAt(clock.now() + 12);
+    EXPECT_EQ(timer.executeSleep(0), ERROR_CODE_OK);
+    EXPECT_EQ(timer.getLastElapsedTime(), 5u);
+    event_set_t eventSet{};
+    ASSERT_EQ(timer.getEventSet(0, eventSet), ERROR_CODE_OK);
+    EXPECT_EQ(eventSet.fired_mask, 0x2u);
+    EXPECT_EQ(eventSet.fired_time[1], 5u);
+
+    clock.advance(20);
+    imu.clear();
+    lidar.clear();
+    lidar.setAt(clock.now() + 5);
+    imu.setAt(clock.now() + 12);
+    EXPECT_EQ(timer.executeSleep(1), ERROR_CODE_OK);
+    EXPECT_EQ(timer.getLastElapsedTime(), 12u);
+    ASSERT_EQ(timer.getEventSet(1, eventSet), ERROR_CODE_OK);
+    EXPECT_EQ(eventSet.fired_mask, 0x3u);
+    EXPECT_EQ(eventSet.fired_time[0], 12u);
+    EXPECT_EQ(eventSet.fired_time[1], 5u);
+
+    EXPECT_THROW(timer.addStep(2, 40, getEventMask, 0, WAIT_ANY_EVENT), std::invalid_argument);
+    EXPECT_THROW(timer.addStep(2, 40, getEventMask, 0x3, WAIT_EVENT), std::invalid_argument);
+}
+
+TEST(eerratic_timer_class, test_slack_reclamation) {
+    EEerraticVirtualClock clock(1000, 1);
+    EEerraticVirtualClock::Event event(clock);
+    EEerraticTimer timer(100,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    timer.addStep(0, 40, [&event] { return event.isSet(); }, WAIT_EVENT);
+    timer.addStep(1, 20, [&event] { return event.isSet(); }, WAIT_EVENT);
+
+    auto runLoop = [&] {
+        timer.resetLoop();
+        event.clear();
+        event.setAt(clock.now() + 10);
+        EXPECT_EQ(timer.executeSleep(0), ERROR_CODE_OK);
+        event.clear();
+        event.setAt(clock.now() + 35);
+        return timer.executeSleep(1);
+    };
+
+    // Without slack the second step overruns its own budget
+    EXPECT_EQ(runLoop(), ERROR_CODE_TIMEOUT);
+    EXPECT_EQ(timer.getLastElapsedTime(), 20u);
+
+    clock.advance(100);
+    timer.enableSlack(25);
+    timer.resetStats();
+    EXPECT_EQ(runLoop(), ERROR_CODE_OK);
+    EXPECT_EQ(timer.getLastElapsedTime(), 35u);
+    EXPECT_EQ(timer.getSlack(), 15u);
+
+    EEerraticTimer::StepStats stats{};
+    ASSERT_EQ(timer.getStepStats(0, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.donatedTime, 30u);
+    EXPECT_EQ(stats.borrowedTime, 0u);
+    ASSERT_EQ(timer.getStepStats(1, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.borrowedTime, 15u);
+    EXPECT_EQ(stats.overrunCount, 0u);
+
+    // The cap bounds what a step may borrow, and a new loop starts with no slack
+    clock.advance(100);
+    timer.enableSlack(10);
+    EXPECT_EQ(runLoop(), ERROR_CODE_TIMEOUT);
+    EXPECT_EQ(timer.getLastElapsedTime(), 30u);
+    timer.resetLoop();
+    EXPECT_EQ(timer.getSlack(), 0u);
+}
+
+TEST(eerratic_timer_class, test_event_latency) {
+    EEerraticVirtualClock clock(1000, 3);
+    EEerraticVirtualClock::Event event(clock);
+    eerratic_tick_t firedTime = 0;
+    EEerraticTimer timer(100,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    timer.addStep(0, 40, [&event] { return event.isSet(); }, WAIT_EVENT);
+    EXPECT_EQ(timer.setEventTimeFunc(0, [&firedTime](eerratic_tick_t& time) {
+        time = firedTime;
+        return true;
+    }), ERROR_CODE_OK);
+    EXPECT_EQ(timer.setEventTimeFunc(9, nullptr), ERROR_CODE_INVALID_PARAMETER);
+
+    // Polls every 3 ticks, so an event at +10 is seen at +12
+    timer.resetLoop();
+    firedTime = clock.now() + 10;
+    event.setAt(firedTime);
+    EXPECT_EQ(timer.executeSleep(0), ERROR_CODE_OK);
+    EEerraticTimer::EventTiming timing{};
+    ASSERT_EQ(timer.getLastEventTiming(0, timing), ERROR_CODE_OK);
+    EXPECT_TRUE(timing.valid);
+    EXPECT_EQ(timing.firedTime, firedTime);
+    EXPECT_EQ(timing.detectedTime, firedTime + 2);
+
+    // An event already set when the step starts costs no latency
+    timer.resetLoop();
+    firedTime = clock.now() - 50;
+    EXPECT_EQ(timer.executeSleep(0), ERROR_CODE_OK);
+
+    // A timed out step has nothing to report
+    event.clear();
+    timer.resetLoop();
+    EXPECT_EQ(timer.executeSleep(0), ERROR_CODE_TIMEOUT);
+    ASSERT_EQ(timer.getLastEventTiming(0, timing), ERROR_CODE_OK);
+    EXPECT_FALSE(timing.valid);
+
+    EEerraticTimer::StepStats stats{};
+    ASSERT_EQ(timer.getStepStats(0, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.eventLatencyCount, 2u);
+    EXPECT_EQ(stats.eventLatencyMax, 2u);
+    EXPECT_EQ(timer.getEventLatencyHistogram(0)->getMin(), 0u);
+}
+
+TEST(eerratic_timer_class, test_virtual_clock_simulation) {
+    // Polls are free, so waits only progress through the blocking backends
+    EEerraticVirtualClock clock(1000, 0);
+    EEerraticVirtualClock::Event event(clock);
+    EEerraticTimer timer(100,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    timer.addStep(0, 40, [&event] { return event.isSet(); }, WAIT_EVENT, WAIT_POLICY_BLOCK,
+        [&event](eerratic_tick_t timeout) { return event.wait(timeout); });
+    timer.addStep(1, 30, [&event] { return event.isSet(); }, WAIT_TIME_AND_EVENT, WAIT_POLICY_BLOCK);
+    timer.addStep(2, 100, nullptr, SLEEP_REMAINING_TIME);
+
+    const int kLoops = 10000;
+    for (int i = 0; i < kLoops; i++) {
+        timer.resetLoop();
+        const eerratic_tick_t loopStart = clock.now();
+        event.clear();
+        event.setAt(loopStart + static_cast<eerratic_tick_t>(i % 50));
+        timer.executeSleep(0);
+        timer.executeSleep(1);
+        timer.executeSleep(2);
+        ASSERT_EQ(clock.now() - loopStart, 100u);
+    }
+    EXPECT_EQ(clock.getSimulatedTime(), 100u * kLoops);
+
+    EEerraticTimer::StepStats stats{};
+    ASSERT_EQ(timer.getStepStats(0, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.count, static_cast<uint64_t>(kLoops));
+    // Events at offsets 41..49 miss the 40 tick budget
+    EXPECT_EQ(stats.overrunCount, static_cast<uint64_t>(kLoops / 50 * 9));
+    EXPECT_EQ(stats.max, 40u);
+    ASSERT_EQ(timer.getStepStats(1, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.overrunCount, 0u);
+    EXPECT_EQ(stats.min, 30u);
+    EXPECT_EQ(stats.max, 30u);
+}
+
+TEST(eerratic_timer_class, test_periodic_no_drift) {
+    EEerraticVirtualClock clock(1000);
+    EEerraticTimer timer(100,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    timer.addStep(0, 100, nullptr, SLEEP_REMAINING_TIME);
+
+    // Work, then sleep to the end of the loop; the next period is always entered 2 ticks late
+    timer.startPeriodic();
+    for (eerratic_tick_t i = 1; i <= 100; i++) {
+        clock.advance(30);
+        timer.executeSleep(0);
+        clock.advance(2);
+        ASSERT_EQ(timer.nextPeriod(), ERROR_CODE_OK);
+        ASSERT_EQ(timer.getLoopStartTime(), 1000 + i * 100);
+    }
+    EXPECT_EQ(timer.getLatePeriodCount(), 100u);
+    EXPECT_EQ(timer.getMissedPeriodCount(), 0u);
+
+    // A boundary still ahead is waited for
+    EXPECT_EQ(timer.nextPeriod(), ERROR_CODE_OK);
+    EXPECT_EQ(clock.now(), 11100u);
+}
+
+TEST(eerratic_timer_class, test_periodic_overrun_policies) {
+    const struct {
+        EEerraticTimer::OverrunPolicy policy;
+        eerratic_tick_t startAfterOverrun;
+        eerratic_tick_t startAfterRecovery;
+    } kCases[] = {
+        { EEerraticTimer::OverrunPolicy::Skip, 200, 300 },
+        { EEerraticTimer::OverrunPolicy::CatchUp, 100, 200 },
+        { EEerraticTimer::OverrunPolicy::PhaseReset, 250, 350 },
+    };
+
+    for (const auto& testCase : kCases) {
+        EEerraticVirtualClock clock(0);
+        EEerraticTimer timer(100,
+            [&clock] { return clock.now(); },
+            [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+        timer.addStep(0, 100, nullptr, SLEEP_REMAINING_TIME);
+        timer.startPeriodic(testCase.policy);
+
+        clock.advance(250);
+        timer.executeSleep(0);
+        EXPECT_EQ(timer.nextPeriod(), ERROR_CODE_TOTAL_TIMEOUT);
+        EXPECT_EQ(timer.getLoopStartTime(), testCase.startAfterOverrun);
+        EXPECT_EQ(timer.getMissedPeriodCount(), 1u);
+
+        timer.executeSleep(0);
+        EXPECT_EQ(timer.nextPeriod(), ERROR_CODE_OK);
+        EXPECT_EQ(timer.getLoopStartTime(), testCase.startAfterRecovery);
+        EXPECT_EQ(timer.getMissedPeriodCount(), 1u);
+    }
+}
+
+using FakeSchedule = EEerraticSchedule<200, get_fake_time_impl, fake_sleep_impl,
+    EEerraticStep<WAIT_EVENT,           80, is_fake_event_set_impl>,
+    EEerraticStep<WAIT_TIME_AND_EVENT,  60, is_fake_event_set_impl>,
+    EEerraticStep<SLEEP_REMAINING_TIME, EERRATIC_LOOP_REMAINDER>>;
+
+static_assert(FakeSchedule::kStepCount == 3, "");
+static_assert(FakeSchedule::kBudgetSum == 140, "");
+static_assert(FakeSchedule::kHeadroom == 60, "");
+
+TEST(eerratic_timer_class, test_budget_tuning_and_feasibility) {
+    EEerraticVirtualClock clock(0, 1);
+    EEerraticVirtualClock::Event event(clock);
+    EEerraticTimer timer(100,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    timer.addStep(0, 20, nullptr, SLEEP_REMAINING_TIME);
+    timer.addStep(1, 60, [&event] { return event.isSet(); }, WAIT_EVENT);
+
+    // The event comes 10 to 14 ticks into the wait, or never
+    auto runLoops = [&](int count, bool fire) {
+        for (int i = 0; i < count; i++) {
+            timer.resetLoop();
+            timer.executeSleep(0);
+            event.clear();
+            if (fire) {
+                event.setAt(clock.now() + 10 + static_cast<eerratic_tick_t>(i % 5));
+            }
+            timer.executeSleep(1);
+            clock.advance(10);
+        }
+    };
+    const EEerraticTimer::AutoTuneConfig tuneConfig{ 99.0, 2, 50 };
+    runLoops(49, true);
+    EXPECT_TRUE(timer.proposeBudgets(tuneConfig).empty());
+    runLoops(1, true);
+
+    std::vector<EEerraticTimer::BudgetProposal> proposals = timer.proposeBudgets(tuneConfig);
+    ASSERT_EQ(proposals.size(), 1u);     // Sleeps are not tuned
+    EXPECT_EQ(proposals[0].id, 1);
+    EXPECT_EQ(proposals[0].current, 60u);
+    EXPECT_EQ(proposals[0].proposed, 16u);
+    EXPECT_EQ(proposals[0].samples, 50u);
+    EXPECT_FALSE(proposals[0].censored);
+    EXPECT_FALSE(proposals[0].capped);
+    proposals = timer.proposeBudgets({ 99.0, 200, 50 });
+    ASSERT_EQ(proposals.size(), 1u);
+    EXPECT_TRUE(proposals[0].capped);
+    EXPECT_EQ(proposals[0].proposed, 100u);
+
+    EEerraticTimer::FeasibilityReport report = timer.getFeasibilityReport();
+    EXPECT_EQ(report.period, 100u);
+    EXPECT_EQ(report.budgetPath, 80u);
+    EXPECT_EQ(report.worstPath, 34u);
+    EXPECT_EQ(report.criticalPath, (std::vector<int>{ 0, 1 }));
+    EXPECT_EQ(report.loopCount, 49u);
+    EXPECT_EQ(report.loopMax, 44u);
+    EXPECT_EQ(report.budgetHeadroom, 20);
+    EXPECT_TRUE(report.fits());
+    EXPECT_NE(report.describe().find("worst path: 34 (headroom 66) steps 0 1"), std::string::npos);
+
+    // Learning restarts under the new budget, which the next timeout shows
+    EXPECT_EQ(timer.applyBudgets(tuneConfig), 1u);
+    EXPECT_TRUE(timer.proposeBudgets(tuneConfig).empty());
+    runLoops(1, false);
+    EXPECT_EQ(timer.getLastElapsedTime(), 16u);
+
+    // Timeouts hide the percentile: auto-tune doubles the budget every 10 runs
+    timer.enableAutoTune({ 99.0, 2, 10 });
+    runLoops(8, false);
+    proposals = timer.proposeBudgets({ 99.0, 2, 1 });
+    ASSERT_EQ(proposals.size(), 1u);
+    EXPECT_TRUE(proposals[0].censored);
+    EXPECT_EQ(proposals[0].proposed, 32u);
+    runLoops(1, false);
+    EXPECT_EQ(timer.getLastElapsedTime(), 16u);
+    runLoops(20, false);
+    EXPECT_EQ(timer.getLastElapsedTime(), 64u);
+    timer.disableAutoTune();
+    runLoops(20, false);
+    EXPECT_EQ(timer.getLastElapsedTime(), 80u);    // 128, capped at 100; the loop deadline comes first
+}
+
+TEST(eerratic_timer_class, test_feasibility_with_loop_remainder) {
+    EEerraticVirtualClock clock;
+    EEerraticVirtualClock::Event event(clock);
+    const eerratic_tick_t loopExpectedElapsedTime = 7000;
+    EEerraticTimer timer(loopExpectedElapsedTime,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    timer.addStep(0, 2500, [&event] { return event.isSet(); }, WAIT_EVENT);
+    timer.addStep(1, 500, [&event] { return event.isSet(); }, WAIT_EVENT);
+    timer.addStep(2, loopExpectedElapsedTime, nullptr, SLEEP_REMAINING_TIME);
+
+    // Step 0 sees its event after 1000, step 1 times out
+    for (int i = 0; i < 10; i++) {
+        timer.resetLoop();
+        event.clear();
+        event.setAt(clock.now() + 1000);
+        timer.executeSleep(0);
+        event.clear();
+        timer.executeSleep(1);
+        timer.executeSleep(2);
+    }
+    timer.resetLoop();
+
+    // The remainder step fills the period; it is neither work nor a budget
+    EEerraticTimer::FeasibilityReport report = timer.getFeasibilityReport();
+    EXPECT_EQ(report.budgetPath, 3000u);
+    EXPECT_EQ(report.criticalPath, (std::vector<int>{ 0, 1 }));
+    EXPECT_EQ(report.worstPath, 1500u);
+    EXPECT_EQ(report.loopCount, 10u);
+    EXPECT_EQ(report.loopMax, 1500u);
+    EXPECT_EQ(report.budgetHeadroom, 4000);
+    EXPECT_TRUE(report.fits());
+    EXPECT_NE(report.describe().find("fits"), std::string::npos);
+}
+
+TEST(eerratic_timer_class, test_load_shedding) {
+    EEerraticVirtualClock clock;
+    EEerraticVirtualClock::Event never(clock);
+    EEerraticTimer timer(100,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    timer.addStep(0, 30, nullptr, SLEEP_REMAINING_TIME);
+    timer.addStep(1, 30, nullptr, SLEEP_REMAINING_TIME);
+    timer.addStep(2, 20, nullptr, SLEEP_REMAINING_TIME);
+    timer.addStep(3, 20, [&never] { return never.isSet(); }, WAIT_EVENT);
+    timer.addStep(4, 100, nullptr, SLEEP_REMAINING_TIME);
+    EXPECT_EQ(timer.setStepCriticality(1, 2), ERROR_CODE_OK);
+    EXPECT_EQ(timer.setStepCriticality(2, 1), ERROR_CODE_OK);
+    EXPECT_EQ(timer.setStepCriticality(5, 1), ERROR_CODE_INVALID_PARAMETER);
+    EEerraticTraceBuffer trace(64);
+    timer.setTraceBuffer(&trace);
+
+    // The loop starts `late` ticks behind; steps 0 and 3 are mandatory and step 4,
+    // the loop remainder, sleeps whatever is left
+    auto runLoop = [&](eerratic_tick_t late, std::vector<ERROR_CODE> expected) {
+        timer.resetLoop();
+        clock.advance(late);
+        for (int id = 0; id < 4; id++) {
+            EXPECT_EQ(timer.executeSleep(id), expected[id]) << "late " << late << " step " << id;
+        }
+        EXPECT_EQ(timer.getLastElapsedTime(), 20u);
+        timer.executeSleep(4);
+        EXPECT_EQ(clock.now() - timer.getLoopStartTime(), 100u);
+    };
+    runLoop(0, { ERROR_CODE_OK, ERROR_CODE_OK, ERROR_CODE_OK, ERROR_CODE_TIMEOUT });
+
+    // Step 1 keeps 40 ticks for steps 2 and 3 and runs on the 5 left
+    runLoop(25, { ERROR_CODE_OK, ERROR_CODE_OK, ERROR_CODE_OK, ERROR_CODE_TIMEOUT });
+    EEerraticTimer::StepStats stats{};
+    ASSERT_EQ(timer.getStepStats(1, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.max, 30u);
+    EXPECT_EQ(stats.min, 5u);
+    EXPECT_EQ(stats.shortenedCount, 1u);
+    EXPECT_EQ(stats.shedCount, 0u);
+
+    // Step 1 would need what steps 2 and 3 take, step 2 what step 3 takes
+    runLoop(50, { ERROR_CODE_OK, ERROR_CODE_SHED, ERROR_CODE_SHED, ERROR_CODE_TIMEOUT });
+    ASSERT_EQ(timer.getStepStats(1, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.shedCount, 1u);
+    EXPECT_EQ(stats.count, 2u);
+    ASSERT_EQ(timer.getStepStats(2, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.shedCount, 1u);
+    EXPECT_EQ(stats.shortenedCount, 0u);
+
+    // The non-blocking pair sheds the same way, and both paths trace it
+    timer.resetLoop();
+    clock.advance(85);
+    EXPECT_EQ(timer.beginStep(timer.getStepHandle(2)), ERROR_CODE_SHED);
+    EEerraticTraceRecord records[64];
+    const size_t count = trace.drain(records, 64);
+    std::vector<int> shedSteps;
+    for (size_t i = 0; i < count; i++) {
+        if (records[i].result == ERROR_CODE_SHED) {
+            shedSteps.push_back(records[i].stepId);
+        }
+    }
+    EXPECT_EQ(shedSteps, (std::vector<int>{ 1, 2, 2 }));
+}
+
+TEST(eerratic_timer_class, test_load_shedding_with_loop_remainder) {
+    EEerraticVirtualClock clock;
+    EEerraticVirtualClock::Event event(clock);
+    const eerratic_tick_t loopExpectedElapsedTime = 7000;
+    EEerraticTimer timer(loopExpectedElapsedTime,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    timer.addStep(0, 2500, [&event] { return event.isSet(); }, WAIT_EVENT);
+    timer.addStep(1, 500, [&event] { return event.isSet(); }, WAIT_EVENT);
+    timer.addStep(2, loopExpectedElapsedTime, nullptr, SLEEP_REMAINING_TIME);
+    timer.setStepCriticality(1, 1);
+
+    // Nothing is kept for the remainder step, so the optional step runs in full
+    for (int i = 0; i < 5; i++) {
+        timer.resetLoop();
+        event.clear();
+        event.setAt(clock.now() + 1000);
+        timer.executeSleep(0);
+        event.clear();
+        EXPECT_EQ(timer.executeSleep(1), ERROR_CODE_TIMEOUT);
+        EXPECT_EQ(timer.getLastElapsedTime(), 500u);
+        timer.executeSleep(2);
+    }
+    EEerraticTimer::StepStats stats{};
+    ASSERT_EQ(timer.getStepStats(1, stats), ERROR_CODE_OK);
+    EXPECT_EQ(stats.shedCount, 0u);
+    EXPECT_EQ(stats.shortenedCount, 0u);
+
+    // Only a loop that already ran out sheds it
+    timer.resetLoop();
+    clock.advance(loopExpectedElapsedTime);
+    EXPECT_EQ(timer.executeSleep(1), ERROR_CODE_SHED);
+}
+
+TEST(eerratic_schedule, test_run_loop) {
+    fake_now = 1000;
+    FakeSchedule schedule;
+
+    std::size_t stepsRun = 0;
+    ERROR_CODE ret = schedule.runLoop([&](auto step) {
+        EXPECT_EQ(step(), stepsRun);
+        stepsRun++;
+        fake_event_time = fake_now + 10;
+    });
+    EXPECT_EQ(ret, ERROR_CODE_OK);
+    EXPECT_EQ(stepsRun, 3u);
+    EXPECT_EQ(schedule.getElapsedTime<0>(), 10u);
+    EXPECT_EQ(schedule.getElapsedTime<1>(), 60u);
+    EXPECT_EQ(schedule.getElapsedTime<2>(), 130u);
+    EXPECT_EQ(fake_now - schedule.getLoopStartTime(), 200u);
+}
+
+TEST(eerratic_schedule, test_step_timeout) {
+    fake_now = 0;
+    FakeSchedule schedule;
+    schedule.resetLoop();
+
+    fake_event_time = fake_now + 100;
+    EXPECT_EQ(schedule.executeSleep<0>(), ERROR_CODE_TIMEOUT);
+    EXPECT_EQ(schedule.getElapsedTime<0>(), 80u);
+    EXPECT_EQ(schedule.executeSleep<2>(), ERROR_CODE_OK);
+    EXPECT_EQ(fake_now, 200u);
+}
+
+// Every clock read costs one tick, so spinning to a deadline terminates
+eerratic_tick_t get_ticking_time_impl() {
+    return fake_now++;
+}
+
+int fake_yield_count = 0;
+
+void fake_yield_impl() {
+    fake_yield_count++;
+}
+
+bool fake_wait_event_impl(eerratic_tick_t timeout) {
+    const eerratic_tick_t remaining = fake_event_time - fake_now;
+    fake_now += (remaining < timeout) ? remaining : timeout;
+    return fake_now >= fake_event_time;
+}
+
+using BackendSchedule = EEerraticSchedule<200, get_ticking_time_impl, fake_sleep_impl,
+    EEerraticStep<WAIT_EVENT, 80, is_fake_event_set_impl, WAIT_POLICY_YIELD, fake_yield_impl>,
+    EEerraticStep<WAIT_EVENT, 60, is_fake_event_set_impl, WAIT_POLICY_BLOCK, nullptr, fake_wait_event_impl>,
+    EEerraticStep<SLEEP_REMAINING_TIME_PRECISE, EERRATIC_LOOP_REMAINDER>>;
+
+TEST(eerratic_schedule, test_wait_backends_and_precise_sleep) {
+    fake_now = 0;
+    fake_yield_count = 0;
+    BackendSchedule schedule;
+    schedule.resetLoop();
+
+    fake_event_time = 10;
+    EXPECT_EQ(schedule.executeSleep<0>(), ERROR_CODE_OK);
+    EXPECT_GT(fake_yield_count, 0);
+
+    // The blocking wait jumps straight to the event instead of polling
+    fake_event_time = fake_now + 30;
+    const eerratic_tick_t blockStart = fake_now;
+    EXPECT_EQ(schedule.executeSleep<1>(), ERROR_CODE_OK);
+    EXPECT_GE(fake_now - blockStart, 30u);
+    EXPECT_LE(fake_now - blockStart, 33u);
+
+    EXPECT_EQ(schedule.executeSleep<2>(), ERROR_CODE_OK);
+    EXPECT_GE(fake_now - schedule.getLoopStartTime(), 200u);
+    EXPECT_LE(fake_now - schedule.getLoopStartTime(), 202u);
+    EXPECT_EQ(schedule.getPreciseSleepState<2>().count, 1u);
+    EXPECT_LE(schedule.getPreciseSleepState<2>().last_error, 1u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,85 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#define EERRATIC_TIME_BASE EERRATIC_TIME_BASE_US64
+
+#include <gtest/gtest.h>
+#include "eerratic_timer.h"
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static_assert(sizeof(eerratic_tick_t) == 8, "US64 time base must use 64-bit ticks");
+static_assert(EERRATIC_TICKS_PER_SEC == 1000000u, "US64 time base must count microseconds");
+
+std::atomic<bool> flag{false};
+
+eerratic_tick_t get_current_time_impl() {
+    using namespace std::chrono;
+    return static_cast<eerratic_tick_t>(
+        duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count()
+    );
+}
+
+void sleep_us_impl(eerratic_tick_t us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+bool is_event_set_impl() {
+    return flag.load();
+}
+
+TEST(eerratic_timer_us64, test_sub_millisecond_step) {
+    const eerratic_tick_t loop_start_time = get_current_time_impl();
+    const eerratic_tick_t loop_expected_elapsed_time = 2000;
+
+    timer_utils_t timer_step{};
+    timer_step.get_current_time_func = get_current_time_impl;
+    timer_step.sleep_func = sleep_us_impl;
+    timer_step.is_event_set_func = is_event_set_impl;
+    timer_step.expected_elapsed_time = 300;
+
+    flag = false;
+    ERROR_CODE ret = eerratic_sleep(loop_start_time, loop_expected_elapsed_time, &timer_step, WAIT_EVENT);
+    EXPECT_EQ(ret, ERROR_CODE_TIMEOUT);
+    EXPECT_GE(timer_step.elapsed_time, 300u);
+    EXPECT_LT(timer_step.elapsed_time, 400u);
+}
+
+eerratic_tick_t fake_now = 0;
+
+eerratic_tick_t get_fake_time_impl() {
+    return fake_now;
+}
+
+void fake_sleep_impl(eerratic_tick_t ticks) {
+    fake_now += ticks;
+}
+
+TEST(eerratic_timer_us64, test_tick_wrap_around) {
+    const eerratic_tick_t loop_start_time = UINT64_MAX - 10;
+
+    fake_now = 5;
+    EXPECT_EQ(is_timer_expired(loop_start_time, 100, UINT64_MAX - 5, 20, get_fake_time_impl), ERROR_CODE_OK);
+    fake_now = 20;
+    EXPECT_EQ(is_timer_expired(loop_start_time, 100, UINT64_MAX - 5, 20, get_fake_time_impl), ERROR_CODE_TIMEOUT);
+
+    timer_utils_t timer_step{};
+    timer_step.get_current_time_func = get_fake_time_impl;
+    timer_step.sleep_func = fake_sleep_impl;
+    timer_step.expected_elapsed_time = 100;
+
+    fake_now = UINT64_MAX - 5;
+    ERROR_CODE ret = eerratic_sleep(loop_start_time, 100, &timer_step, SLEEP_REMAINING_TIME);
+    EXPECT_EQ(ret, ERROR_CODE_OK);
+    EXPECT_EQ(timer_step.elapsed_time, 95u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include "eerratic_timer_class.hpp"
+#include "eerratic_trace.hpp"
+#include "eerratic_virtual_clock.hpp"
+
+#include <sstream>
+#include <string>
+
+TEST(eerratic_trace, test_ring_buffer_wraps_and_drops) {
+    EEerraticTraceBuffer buffer(3);
+    EXPECT_EQ(buffer.capacity(), 4u);
+
+    EEerraticTraceRecord out[8];
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 5; i++) {
+            buffer.push({ 0, 1, i, ERROR_CODE_OK, 0 });
+        }
+        ASSERT_EQ(buffer.drain(out, 8), 4u);
+        for (int i = 0; i < 4; i++) {
+            EXPECT_EQ(out[i].stepId, i);
+        }
+    }
+    EXPECT_EQ(buffer.getDroppedCount(), 3u);
+    EXPECT_EQ(buffer.drain(out, 8), 0u);
+}
+
+TEST(eerratic_trace, test_timer_chrome_trace) {
+    EEerraticVirtualClock clock(0, 1);
+    EEerraticVirtualClock::Event event(clock);
+    EEerraticTimer timer(100,
+        [&clock] { return clock.now(); },
+        [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+    timer.addStep(3, 20, nullptr, SLEEP_REMAINING_TIME);
+    timer.addStep(7, 10, [&event] { return event.isSet(); }, WAIT_EVENT);
+
+    EEerraticTraceBuffer buffer(16);
+    timer.setTraceBuffer(&buffer, 5);
+    timer.resetLoop();
+    timer.executeSleep(3);
+    timer.executeSleep(7);
+    timer.setTraceBuffer(nullptr);
+    timer.executeSleep(7);
+
+    std::ostringstream stream;
+    ASSERT_EQ(exportChromeTrace(buffer, stream), 2u);
+    const std::string json = stream.str();
+    EXPECT_EQ(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+    EXPECT_NE(json.find("\"name\":\"step 3\",\"cat\":\"step\",\"ph\":\"X\",\"pid\":1,\"tid\":5"), std::string::npos);
+    EXPECT_NE(json.find("\"name\":\"step 7\",\"cat\":\"overrun\""), std::string::npos);
+    EXPECT_NE(json.find("\"result\":\"TIMEOUT\""), std::string::npos);
+    EXPECT_EQ(json.substr(json.size() - 3), "]}\n");
+}
+
+TEST(eerratic_trace, test_chrome_trace_large_timestamps) {
+    // About one day of uptime: 8.64e10 us must not lose its low digits
+    const eerratic_tick_t begin = 86400 * EERRATIC_TICKS_PER_SEC + 123 * EERRATIC_TICKS_PER_MS;
+    EEerraticTraceBuffer buffer(4);
+    buffer.push({ begin, begin + 2 * EERRATIC_TICKS_PER_MS, 1, ERROR_CODE_OK, 0 });
+    buffer.push({ begin + 3 * EERRATIC_TICKS_PER_MS, begin + 4 * EERRATIC_TICKS_PER_MS, 2, ERROR_CODE_OK, 0 });
+
+    std::ostringstream stream;
+    ASSERT_EQ(exportChromeTrace(buffer, stream), 2u);
+    const std::string json = stream.str();
+    EXPECT_NE(json.find("\"ts\":86400123000,\"dur\":2000,"), std::string::npos);
+    EXPECT_NE(json.find("\"ts\":86400126000,\"dur\":1000,"), std::string::npos);
+}
@@ -0,0 +1,130 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <gtest/gtest.h>
+#include "eerratic_clock.h"
+#include "eerratic_timer_class.hpp"
+#include "eerratic_virtual_clock.hpp"
+#include "eerratic_watchdog.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void sleep_ticks(eerratic_tick_t ticks) {
+    std::this_thread::sleep_for(std::chrono::duration<int64_t, std::ratio<1, EERRATIC_TICKS_PER_SEC>>(ticks));
+}
+
+// Blocks like a stalled bus read until the flag is set (or a safety timeout)
+bool waitFor(const std::atomic<bool>& flag) {
+    const auto giveUp = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!flag && std::chrono::steady_clock::now() < giveUp) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return flag;
+}
+
+struct MissLog {
+    std::mutex mutex;
+    std::vector<EEerraticWatchdog::Miss> misses;
+    std::atomic<bool> stepMissed{false};
+    std::atomic<bool> loopMissed{false};
+
+    void add(const EEerraticWatchdog::Miss& miss) {
+        std::lock_guard<std::mutex> lock(mutex);
+        misses.push_back(miss);
+        (miss.kind == EEerraticWatchdog::MissKind::Step ? stepMissed : loopMissed) = true;
+    }
+};
+
+} // namespace
+
+TEST(eerratic_watchdog, test_reports_stalled_step_and_loop) {
+    const eerratic_tick_t ms = EERRATIC_TICKS_PER_MS;
+    MissLog log;
+    EEerraticWatchdog watchdog(eerratic_monotonic_time, ms, 2 * ms);
+    watchdog.addHandler([&log](const EEerraticWatchdog::Miss& miss) { log.add(miss); });
+    watchdog.start();
+    EXPECT_THROW(watchdog.addHandler([](const EEerraticWatchdog::Miss&) {}), std::logic_error);
+
+    EEerraticTimer timer(100 * ms, eerratic_monotonic_time, sleep_ticks);
+    timer.addStep(4, 20 * ms, [&log] { return waitFor(log.stepMissed); }, WAIT_EVENT);
+    timer.addStep(5, 20 * ms, [] { return true; }, WAIT_EVENT);
+    timer.setWatchdog(&watchdog, 7);
+
+    // The callback only returns once the watchdog reported the step it blocks
+    timer.resetLoop();
+    EXPECT_EQ(timer.executeSleep(4), ERROR_CODE_OK);
+    EXPECT_TRUE(log.stepMissed);
+    EXPECT_EQ(timer.executeSleep(5), ERROR_CODE_OK);
+
+    // Work between steps that runs past the loop budget
+    EXPECT_TRUE(waitFor(log.loopMissed));
+    timer.resetLoop();
+    timer.setWatchdog(nullptr);
+    watchdog.stop();
+
+    std::lock_guard<std::mutex> lock(log.mutex);
+    ASSERT_EQ(log.misses.size(), 2u);
+    const EEerraticWatchdog::Miss& stepMiss = log.misses[0];
+    EXPECT_EQ(stepMiss.channelId, 7u);
+    EXPECT_EQ(stepMiss.stepId, 4);
+    EXPECT_EQ(stepMiss.kind, EEerraticWatchdog::MissKind::Step);
+    EXPECT_GT(stepMiss.overrun, 2 * ms);
+    EXPECT_EQ(stepMiss.detectedTime - stepMiss.deadline, stepMiss.overrun);
+    EXPECT_EQ(log.misses[1].kind, EEerraticWatchdog::MissKind::Loop);
+    EXPECT_EQ(log.misses[1].stepId, -1);
+}
+
+TEST(eerratic_watchdog, test_channel_overrun_statistics) {
+    // Without start() nothing is reported, but the channel still measures overruns
+    EEerraticVirtualClock clock(0, 1);
+    EEerraticWatchdog watchdog([&clock] { return clock.now(); }, 1, 3);
+    EEerraticWatchdog::Channel& channel = watchdog.addChannel(1);
+    EXPECT_EQ(channel.getId(), 1u);
+
+    channel.beginLoop(100);
+    channel.beginStep(2, 10);
+    channel.endStep(12);        // Within the tolerance
+    channel.beginStep(2, 20);
+    channel.endStep(30);
+    channel.endLoop(150);
+    channel.endLoop(400);       // Nothing armed
+
+    EEerraticWatchdog::ChannelStats stats = channel.getStats();
+    EXPECT_EQ(stats.stepMisses, 0u);
+    EXPECT_EQ(stats.stepOverruns, 1u);
+    EXPECT_EQ(stats.maxStepOverrun, 10u);
+    EXPECT_EQ(stats.loopOverruns, 1u);
+    EXPECT_EQ(stats.maxLoopOverrun, 50u);
+}
+
+TEST(eerratic_watchdog, test_detached_channels_are_removed) {
+    EEerraticVirtualClock clock(0, 1);
+    EEerraticWatchdog watchdog([&clock] { return clock.now(); });
+    {
+        EEerraticTimer timer(100,
+            [&clock] { return clock.now(); },
+            [&clock](eerratic_tick_t ticks) { clock.sleep(ticks); });
+        for (int i = 0; i < 10; i++) {
+            timer.setWatchdog(&watchdog, 3);
+        }
+        EXPECT_EQ(watchdog.getChannelCount(), 1u);
+        timer.setWatchdog(nullptr);
+        EXPECT_EQ(watchdog.getChannelCount(), 0u);
+        timer.setWatchdog(&watchdog, 3);
+    }
+    // Destroying the timer removes its channel too
+    EXPECT_EQ(watchdog.getChannelCount(), 0u);
+
+    EEerraticWatchdog other([&clock] { return clock.now(); });
+    EXPECT_THROW(other.removeChannel(watchdog.addChannel(1)), std::invalid_argument);
+}
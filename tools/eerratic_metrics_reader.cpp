@@ -0,0 +1,72 @@
+/*
+ * Copyright (c) 2024 Ar-Ray-code
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+// Dumps the metrics file of an EEerraticMetricsExporter once, or every
+// interval_ms when an interval is given. Times are printed in microseconds.
+//
+//   eerratic_metrics_reader <file> [interval_ms]
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <thread>
+
+#include "eerratic_metrics.hpp"
+
+
+namespace {
+
+double toUs(uint64_t ticks, uint64_t ticksPerSec) {
+    return static_cast<double>(ticks) * 1e6 / static_cast<double>(ticksPerSec);
+}
+
+void dump(const EEerraticMetricsReader& reader) {
+    const uint64_t ticksPerSec = reader.getTicksPerSec();
+    const EEerraticMetricsReader::LoopSnapshot loop = reader.readLoop();
+    std::cout << "loops=" << loop.loopCount
+              << " overruns=" << loop.loopOverrunCount
+              << " last_us=" << toUs(loop.lastLoopElapsed, ticksPerSec)
+              << " max_us=" << toUs(loop.maxLoopElapsed, ticksPerSec)
+              << (loop.torn ? " torn" : "") << "\n";
+
+    std::cout << "step,count,timeouts,last_us,max_us,torn\n";
+    EEerraticMetricsReader::StepSnapshot step;
+    for (uint32_t slot = 0; reader.readStep(slot, step); slot++) {
+        if (step.count == 0) {
+            continue;
+        }
+        std::cout << step.stepId << "," << step.count << "," << step.timeoutCount << ","
+                  << toUs(step.lastElapsed, ticksPerSec) << "," << toUs(step.maxElapsed, ticksPerSec) << ","
+                  << (step.torn ? 1 : 0) << "\n";
+    }
+    std::cout << std::flush;
+}
+
+} // namespace
+
+
+int main(int argc, char** argv) {
+    if (argc < 2 || argc > 3) {
+        std::cerr << "usage: " << argv[0] << " <file> [interval_ms]" << std::endl;
+        return 2;
+    }
+    const long intervalMs = (argc == 3) ? std::strtol(argv[2], nullptr, 10) : 0;
+
+    try {
+        EEerraticMetricsReader reader(argv[1]);
+        dump(reader);
+        while (intervalMs > 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+            std::cout << "\n";
+            dump(reader);
+        }
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}